@@ -0,0 +1,291 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <dirent.h>
+
+#include "affinity/affinity.h"
+#include "logger/liblogger.h"
+#include "utils/utils.h"
+
+#define CASE_ENUM_TO_STRING_(error) case error: return #error
+const char* affinity_strerror(const enum AffinityError error)
+{
+    switch(error)
+    {
+        CASE_ENUM_TO_STRING_(AFFINITY_ERROR_SUCCESS);
+        CASE_ENUM_TO_STRING_(AFFINITY_ERROR_STANDARD_ERRNO);
+        CASE_ENUM_TO_STRING_(AFFINITY_ERROR_UNKNOWN_POLICY);
+        CASE_ENUM_TO_STRING_(AFFINITY_ERROR_NO_CPUS);
+        default:
+            return "UNKNOWN_AFFINITY_ERROR";
+    }
+    return "UNKNOWN_AFFINITY_ERROR";
+}
+#undef CASE_ENUM_TO_STRING_
+
+static_assert(AFFINITY_MAX_CPUS <= CPU_SETSIZE, "");
+
+#define SYSFS_CPU_ "/sys/devices/system/cpu/"
+#define LIST_SIZE_ 4096
+
+typedef struct AffinityCpu
+{
+    int cpu;
+    int node;
+    int package;
+    int core;
+    int smt;        // index among the hyperthreads of its core
+    int core_rank;  // index of its core inside the node
+} affinity_cpu_t;
+
+// "0,2,8-11" into cpus, false on anything else
+static bool parse_list_(const char* list, int* const cpus, size_t* const cpus_cnt)
+{
+    *cpus_cnt = 0;
+    while (*list && *list != '\n')
+    {
+        char* end = NULL;
+        const long first = strtol(list, &end, 10);
+        long last = first;
+        if (end == list || first < 0)
+            return false;
+
+        if (*end == '-')
+        {
+            list = end + 1;
+            last = strtol(list, &end, 10);
+            if (end == list || last < first)
+                return false;
+        }
+
+        for (long cpu = first; cpu <= last; ++cpu)
+        {
+            if (cpu >= AFFINITY_MAX_CPUS || *cpus_cnt == AFFINITY_MAX_CPUS)
+                return false;
+            cpus[(*cpus_cnt)++] = (int)cpu;
+        }
+
+        if (*end == ',')
+            ++end;
+        else if (*end && *end != '\n')
+            return false;
+        list = end;
+    }
+
+    return *cpus_cnt;
+}
+
+static int read_int_(const char* const filename, const int fallback)
+{
+    FILE* const file = fopen(filename, "rb");
+    if (!file)
+        return fallback;
+
+    int value = fallback;
+    if (fscanf(file, "%d", &value) != 1)
+        value = fallback;
+    fclose(file);
+
+    return value;
+}
+
+static enum AffinityError online_cpus_(int* const cpus, size_t* const cpus_cnt)
+{
+    FILE* const file = fopen(SYSFS_CPU_ "online", "rb");
+    if (!file)
+    {
+        perror("Can't fopen " SYSFS_CPU_ "online");
+        return AFFINITY_ERROR_STANDARD_ERRNO;
+    }
+
+    char list[LIST_SIZE_] = {};
+    const bool is_read = fgets(list, LIST_SIZE_, file);
+    fclose(file);
+
+    if (!is_read || !parse_list_(list, cpus, cpus_cnt))
+        return AFFINITY_ERROR_NO_CPUS;
+
+    return AFFINITY_ERROR_SUCCESS;
+}
+
+int affinity_cpu_node(const int cpu)
+{
+    char dirname[FILENAME_MAX] = {};
+    snprintf(dirname, FILENAME_MAX, SYSFS_CPU_ "cpu%d", cpu);
+
+    DIR* const dir = opendir(dirname);
+    if (!dir)
+        return -1;
+
+    int node = -1;
+    for (const struct dirent* entry = readdir(dir); entry && node < 0; entry = readdir(dir))
+    {
+        if (sscanf(entry->d_name, "node%d", &node) != 1)
+            node = -1;
+    }
+    closedir(dir);
+
+    return node;
+}
+
+static void read_topology_(affinity_cpu_t* const cpu)
+{
+    char filename[FILENAME_MAX] = {};
+
+    cpu->node = MAX(affinity_cpu_node(cpu->cpu), 0);
+
+    snprintf(filename, FILENAME_MAX, SYSFS_CPU_ "cpu%d/topology/physical_package_id", cpu->cpu);
+    cpu->package = read_int_(filename, 0);
+
+    snprintf(filename, FILENAME_MAX, SYSFS_CPU_ "cpu%d/topology/core_id", cpu->cpu);
+    cpu->core = read_int_(filename, cpu->cpu);
+}
+
+static int cmp_compact_(const void* const first_void, const void* const second_void)
+{
+    const affinity_cpu_t* const first  = (const affinity_cpu_t*)first_void;
+    const affinity_cpu_t* const second = (const affinity_cpu_t*)second_void;
+
+    if (first->node    != second->node)     return first->node    < second->node    ? -1 : 1;
+    if (first->package != second->package)  return first->package < second->package ? -1 : 1;
+    if (first->core    != second->core)     return first->core    < second->core    ? -1 : 1;
+    return (first->cpu > second->cpu) - (first->cpu < second->cpu);
+}
+
+static int cmp_scatter_(const void* const first_void, const void* const second_void)
+{
+    const affinity_cpu_t* const first  = (const affinity_cpu_t*)first_void;
+    const affinity_cpu_t* const second = (const affinity_cpu_t*)second_void;
+
+    if (first->smt       != second->smt)        return first->smt       < second->smt       ? -1 : 1;
+    if (first->core_rank != second->core_rank)  return first->core_rank < second->core_rank ? -1 : 1;
+    return (first->node > second->node) - (first->node < second->node);
+}
+
+// orders the online cpus, cpus of the same core are adjacent after the compact sort
+static enum AffinityError order_cpus_(const bool is_scatter, int* const order, size_t* const cpus_cnt)
+{
+    int online[AFFINITY_MAX_CPUS] = {};
+    AFFINITY_ERROR_HANDLE(online_cpus_(online, cpus_cnt));
+
+    affinity_cpu_t* const cpus = calloc(*cpus_cnt, sizeof(*cpus));
+    if (!cpus)
+    {
+        perror("Can't calloc affinity cpus");
+        return AFFINITY_ERROR_STANDARD_ERRNO;
+    }
+
+    for (size_t cpu = 0; cpu < *cpus_cnt; ++cpu)
+    {
+        cpus[cpu].cpu = online[cpu];
+        read_topology_(&cpus[cpu]);
+    }
+    qsort(cpus, *cpus_cnt, sizeof(*cpus), cmp_compact_);
+
+    for (size_t cpu = 0; cpu < *cpus_cnt; ++cpu)
+    {
+        const affinity_cpu_t* const prev = cpu ? &cpus[cpu - 1] : NULL;
+        const bool is_same_node = prev && prev->node == cpus[cpu].node;
+        const bool is_same_core = is_same_node && prev->package == cpus[cpu].package
+                                               && prev->core    == cpus[cpu].core;
+
+        cpus[cpu].smt       = is_same_core ? prev->smt + 1 : 0;
+        cpus[cpu].core_rank = is_same_core ? prev->core_rank
+                            : is_same_node ? prev->core_rank + 1 : 0;
+    }
+    if (is_scatter)
+    {
+        qsort(cpus, *cpus_cnt, sizeof(*cpus), cmp_scatter_);
+    }
+
+    for (size_t cpu = 0; cpu < *cpus_cnt; ++cpu)
+    {
+        order[cpu] = cpus[cpu].cpu;
+    }
+    free(cpus);
+
+    return AFFINITY_ERROR_SUCCESS;
+}
+
+bool affinity_is_policy(const char* const name)
+{
+    lassert(!is_invalid_ptr(name), "");
+
+    int cpus[AFFINITY_MAX_CPUS] = {};
+    size_t cpus_cnt = 0;
+
+    return name[0] == '\0' || !strcmp(name, "none") || !strcmp(name, "compact") || !strcmp(name, "scatter")
+        || parse_list_(name, cpus, &cpus_cnt);
+}
+
+enum AffinityError affinity_plan(const char* const name, const size_t threads_cnt, int* const cpus)
+{
+    lassert(!is_invalid_ptr(name), "");
+    lassert(!is_invalid_ptr(cpus), "");
+
+    int order[AFFINITY_MAX_CPUS] = {};
+    size_t cpus_cnt = 0;
+
+    if (name[0] == '\0' || !strcmp(name, "none"))
+    {
+        for (size_t thread = 0; thread < threads_cnt; ++thread)
+        {
+            cpus[thread] = AFFINITY_NO_CPU;
+        }
+        return AFFINITY_ERROR_SUCCESS;
+    }
+    else if (!strcmp(name, "compact") || !strcmp(name, "scatter"))
+    {
+        AFFINITY_ERROR_HANDLE(order_cpus_(!strcmp(name, "scatter"), order, &cpus_cnt));
+    }
+    else if (!parse_list_(name, order, &cpus_cnt))
+    {
+        fprintf(stderr, "Unknown affinity '%s', policies: none compact scatter or a core list like 0,2,8-11\n",
+                        name);
+        return AFFINITY_ERROR_UNKNOWN_POLICY;
+    }
+
+    for (size_t thread = 0; thread < threads_cnt; ++thread)
+    {
+        cpus[thread] = order[thread % cpus_cnt];
+    }
+
+    return AFFINITY_ERROR_SUCCESS;
+}
+
+enum AffinityError affinity_pin(const int cpu)
+{
+    cpu_set_t cpu_set = {};
+    CPU_ZERO(&cpu_set);
+
+    if (cpu == AFFINITY_NO_CPU)
+    {
+        int online[AFFINITY_MAX_CPUS] = {};
+        size_t online_cnt = 0;
+        AFFINITY_ERROR_HANDLE(online_cpus_(online, &online_cnt));
+
+        for (size_t online_cpu = 0; online_cpu < online_cnt; ++online_cpu)
+        {
+            lassert(online[online_cpu] < CPU_SETSIZE, "");
+            CPU_SET((size_t)online[online_cpu], &cpu_set);
+        }
+    }
+    else
+    {
+        lassert(cpu >= 0 && cpu < CPU_SETSIZE, "");
+        CPU_SET((size_t)cpu, &cpu_set);
+    }
+
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set))
+    {
+        perror("Can't sched_setaffinity");
+        return AFFINITY_ERROR_STANDARD_ERRNO;
+    }
+
+    return AFFINITY_ERROR_SUCCESS;
+}
+#undef SYSFS_CPU_
+#undef LIST_SIZE_
@@ -0,0 +1,49 @@
+#ifndef AFFINITY_SRC_AFFINITY_AFFINITY_H
+#define AFFINITY_SRC_AFFINITY_AFFINITY_H
+
+#include <assert.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+enum AffinityError
+{
+    AFFINITY_ERROR_SUCCESS          = 0,
+    AFFINITY_ERROR_STANDARD_ERRNO   = 1,
+    AFFINITY_ERROR_UNKNOWN_POLICY   = 2,
+    AFFINITY_ERROR_NO_CPUS          = 3,
+};
+static_assert(AFFINITY_ERROR_SUCCESS  == 0, "");
+
+const char* affinity_strerror(const enum AffinityError error);
+
+#define AFFINITY_ERROR_HANDLE(call_func, ...)                                                       \
+    do {                                                                                            \
+        enum AffinityError error_handler = call_func;                                               \
+        if (error_handler)                                                                          \
+        {                                                                                           \
+            fprintf(stderr, "Can't " #call_func". Error: %s\n",                                     \
+                            affinity_strerror(error_handler));                                      \
+            __VA_ARGS__                                                                             \
+            return error_handler;                                                                   \
+        }                                                                                           \
+    } while(0)
+
+#define AFFINITY_MAX_CPUS   1024    // no more than CPU_SETSIZE
+#define AFFINITY_NO_CPU     (-1)
+
+// none, compact, scatter or a core list whose cores are all below AFFINITY_MAX_CPUS
+bool affinity_is_policy(const char* const name);
+
+// "none" gives every thread all online cpus, "compact" fills the cores of one node first with
+// hyperthread siblings next to each other, "scatter" deals one core per node in turn and siblings last,
+// anything else is a core list like "0,2,8-11" that threads take round robin
+enum AffinityError affinity_plan(const char* const name, const size_t threads_cnt, int* const cpus);
+
+// AFFINITY_NO_CPU gives the calling thread back the cpus the process started with
+enum AffinityError affinity_pin(const int cpu);
+
+// -1 when the kernel exposes no NUMA nodes
+int affinity_cpu_node(const int cpu);
+
+#endif /* AFFINITY_SRC_AFFINITY_AFFINITY_H */
@@ -4,18 +4,35 @@ import numpy as np
 from scipy import stats
 from math import log, sqrt
 
-def process_file(filename, repeats):
-    iterations = []
-    times = []
-    
+STAGES = ('events', 'compute', 'colorize', 'upload', 'present')
+
+def read_columns(filename):
+    header = ['frame', 'tiks']
+    columns = {}
+
     with open(filename, 'r') as file:
         for line in file:
             parts = line.strip().split()
+            if not parts:
+                continue
+            if parts[0] == '#':
+                if len(parts) > 1 and parts[1] == 'frame':
+                    header = parts[1:]
+                continue
             if len(parts) >= 2:
-                iteration = int(parts[0])
-                time = float(parts[1])
-                iterations.append(iteration)
-                times.append(1 / (time / repeats))
+                for name, value in zip(header, parts):
+                    columns.setdefault(name, []).append(float(value))
+
+    return header, columns
+
+SAMPLE_ACCEPTED = 1
+
+def process_file(filename, repeats):
+    _, columns = read_columns(filename)
+    times = columns.get('ns', columns.get('tiks', []))
+    if 'sample' in columns:
+        times = [time for time, sample in zip(times, columns['sample']) if sample == SAMPLE_ACCEPTED]
+    times = [1 / (time / repeats) for time in times]
     
     if not times:
         return None, None
@@ -25,6 +42,24 @@ def process_file(filename, repeats):
     
     return mean_time, sem
 
+def print_stages(filename):
+    header, columns = read_columns(filename)
+    stages = [name for name in header[2:] if name in STAGES]
+    if not stages or not columns.get('tiks'):
+        return
+
+    total = np.mean(columns['tiks'])
+    print(f'{filename} stages:')
+    for stage in stages:
+        mean = np.mean(columns[stage])
+        sem = stats.sem(columns[stage]) if len(columns[stage]) > 1 else 0
+        print(f'    {stage:<10} {mean:14.0f} ± {sem:10.0f} tiks  {100 * mean / total:6.2f}%')
+
+    for name in ('ns_per_pixel', 'ns_per_pixel_iter', 'cycles_per_pixel_iter', 'ipc', 'vector_share'):
+        values = [value for value in columns.get(name, []) if not np.isnan(value)]
+        if values:
+            print(f'    {name:<22} {np.mean(values):.4f} ± {stats.sem(values):.4f}')
+
 def plot_comparison(input_files, output_file, measurements, repeats):
     averages = []
     sems = []
@@ -58,7 +93,8 @@ def plot_comparison(input_files, output_file, measurements, repeats):
         # plt.text(bar.get_x() + bar.get_width()/2., height + 0.01*max(averages),
         #         f'{ratio}',
         #         ha='center', va='bottom', fontsize=9)
-        print(f'{input_files[i]}\n{ratio} & {1/averages[i]/1000_000:.4f} ± {sems[i]/averages[i]/averages[i]/1000_000:.4f}')
+        print(f'{input_files[i]}\n{ratio} & {1/averages[i]/1000_000:.4f} ± {sems[i]/averages[i]/averages[i]/1000_000:.4f} мс')
+        print_stages(input_files[i])
         
     nums = [i for i in range(len(input_files))];
     # for i in range(len(input_files)):
@@ -67,7 +103,7 @@ def plot_comparison(input_files, output_file, measurements, repeats):
         
     plt.xticks(x, nums, rotation=0, ha='right')
     plt.xlabel('Версии программы')
-    plt.ylabel('Обратная величина ко времени выполнения 1 итерации (1/такт)')
+    plt.ylabel('Обратная величина ко времени выполнения 1 итерации (1/нс)')
     
     title = f'Сравнение производительности\n'
     title += f'Измерений: {measurements}, Повторов: {repeats}'
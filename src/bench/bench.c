@@ -0,0 +1,435 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "bench/bench.h"
+#include "mandelbrat2/mandelbrat2.h"
+#include "time_checker/time_checker.h"
+#include "logger/liblogger.h"
+#include "utils/utils.h"
+#include "stats/stats.h"
+#include "affinity/affinity.h"
+
+#define CASE_ENUM_TO_STRING_(error) case error: return #error
+const char* bench_strerror(const enum BenchError error)
+{
+    switch(error)
+    {
+        CASE_ENUM_TO_STRING_(BENCH_ERROR_SUCCESS);
+        CASE_ENUM_TO_STRING_(BENCH_ERROR_STANDARD_ERRNO);
+        CASE_ENUM_TO_STRING_(BENCH_ERROR_MANDELBRAT2);
+        CASE_ENUM_TO_STRING_(BENCH_ERROR_AFFINITY);
+        default:
+            return "UNKNOWN_BENCH_ERROR";
+    }
+    return "UNKNOWN_BENCH_ERROR";
+}
+#undef CASE_ENUM_TO_STRING_
+
+typedef struct BenchScene
+{
+    const char* name;
+    double center_x;
+    double center_y;
+    double span;        // view width in the complex plane
+    size_t iters_cnt;
+} bench_scene_t;
+
+static const bench_scene_t SCENES_[] = {
+    {"full",            -0.5,           0.0,            3.0,    256},
+    {"seahorse_valley", -0.75,          0.1,            0.05,   512},
+    {"interior_heavy",  -0.2,           0.0,            0.6,    256},
+    {"exterior_only",    1.1,           0.0,            1.0,    256},
+    // float kernels start to lose sub-pixel precision around this span
+    {"deep_zoom",       -0.743643887,   0.131825904,    1e-4,   1024},
+};
+#define SCENES_CNT_ (sizeof(SCENES_) / sizeof(*SCENES_))
+
+// widths are multiples of 32 and heights of 4, so every kernel runs on whole blocks without a scalar tail
+static const struct { int width; int height; } RESOLUTIONS_[] = {
+    {256,  128},
+    {512,  256},
+    {1024, 512},
+};
+#define RESOLUTIONS_CNT_ (sizeof(RESOLUTIONS_) / sizeof(*RESOLUTIONS_))
+
+// the affinity comparison renders whole threaded frames of the first scene at this resolution
+static const char* const AFFINITY_POLICIES_[] = {"none", "compact", "scatter"};
+#define AFFINITY_POLICIES_CNT_  (sizeof(AFFINITY_POLICIES_) / sizeof(*AFFINITY_POLICIES_))
+#define AFFINITY_WIDTH_         1024
+#define AFFINITY_HEIGHT_        512
+
+#define BENCH_DEFAULT_MEASURE_CNT_  15
+#define BENCH_MAX_WARMUP_WINDOWS_   4
+
+typedef struct BenchSummary
+{
+    double median;
+    double mad;
+    double ci_low;
+    double ci_high;
+} bench_summary_t;
+
+static int cmp_double_(const void* const first, const void* const second)
+{
+    const double first_val  = *(const double*)first;
+    const double second_val = *(const double*)second;
+    return (first_val > second_val) - (first_val < second_val);
+}
+
+static double sorted_median_(const double* const sorted, const size_t cnt)
+{
+    return (cnt & 1) ? sorted[cnt / 2] : (sorted[cnt / 2 - 1] + sorted[cnt / 2]) / 2;
+}
+
+// 95% confidence interval of the median from order statistics, no normality assumed
+#define Z_95_ 1.96
+static bench_summary_t summarize_(double* const samples, double* const scratch, const size_t cnt)
+{
+    lassert(cnt, "");
+
+    qsort(samples, cnt, sizeof(*samples), cmp_double_);
+
+    bench_summary_t summary = {};
+    summary.median = sorted_median_(samples, cnt);
+
+    for (size_t sample = 0; sample < cnt; ++sample)
+    {
+        scratch[sample] = fabs(samples[sample] - summary.median);
+    }
+    qsort(scratch, cnt, sizeof(*scratch), cmp_double_);
+    summary.mad = sorted_median_(scratch, cnt);
+
+    const double half_width = Z_95_ * sqrt((double)cnt) / 2;
+    const double low_rank   = floor((double)cnt / 2 - half_width);
+    const double high_rank  = ceil ((double)cnt / 2 + half_width);
+
+    summary.ci_low  = samples[(size_t)MAX(low_rank, 0.)];
+    summary.ci_high = samples[(size_t)MIN(high_rank, (double)(cnt - 1))];
+
+    return summary;
+}
+#undef Z_95_
+
+static void set_scene_(mandelbrat2_state_t* const state, const bench_scene_t* const scene,
+                       const int width, const int height)
+{
+    state->iters_cnt        = scene->iters_cnt;
+    state->use_auto_iters   = false;
+    state->scale            = (float)((double)width / scene->span);
+    state->x_offset         = (float)((double)(width  >> 1) - scene->center_x * (double)state->scale);
+    state->y_offset         = (float)((double)(height >> 1) - scene->center_y * (double)state->scale);
+}
+
+static void fprint_summary_(FILE* const out, const char* const name, const bench_summary_t summary)
+{
+    fprintf(out, "\"%s\": {\"median\": %.6f, \"mad\": %.6f, \"ci95_low\": %.6f, \"ci95_high\": %.6f}",
+                 name, summary.median, summary.mad, summary.ci_low, summary.ci_high);
+}
+
+static void fprint_workload_(FILE* const out, const mandelbrat2_workload_t* const workload)
+{
+    fprintf(out, "\"useful_iters\": %lu, \"vector_iters\": %lu, \"tail_iters\": %lu, \"lanes\": %zu, "
+                 "\"lane_utilization\": %.4f,\n     "
+                 "\"escape_hist\": {\"bin_width\": %zu, \"interior\": %lu, \"bins\": [",
+                 workload->useful_iters, workload->vector_iters, workload->tail_iters, workload->lanes,
+                 mandelbrat2_lane_utilization(workload), workload->hist_bin_width, 
+                 workload->interior_cnt);
+
+    for (size_t bin = 0; bin < MANDELBRAT2_HIST_BINS; ++bin)
+    {
+        fprintf(out, "%s%lu", bin ? ", " : "", workload->hist[bin]);
+    }
+    fprintf(out, "]}");
+}
+
+typedef struct BenchSamples
+{
+    size_t capacity;
+    size_t cnt;
+    double* ns_per_pixel;
+    double* ns_per_iter;
+    double* scratch;
+
+    online_stats_t stats;
+} bench_samples_t;
+
+typedef void (*bench_frame_t)(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs);
+
+static void compute_kernel_frame_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const mandelbrat2_rect_t FRAME_RECT = {0, 0, (size_t)flags_objs->screen_width, 
+                                                 (size_t)flags_objs->screen_height};
+
+    mandelbrat2_compute_rect(mandelbrat2_kernel(state->kernel), state->iters, FRAME_RECT.width, state, 
+                             &FRAME_RECT);
+}
+
+// the tiled, threaded path of the window without the texture
+static void compute_threaded_frame_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    print_frame(NULL, state, flags_objs);
+}
+
+// samples before the drift test passes and outliers are not stored;
+// a series that never settles falls back to its last window
+static void measure_(bench_samples_t* const samples, mandelbrat2_state_t* const state,
+                     const flags_objs_t* const flags_objs, const bench_frame_t frame,
+                     mandelbrat2_workload_t* const workload)
+{
+    const size_t PIXELS_CNT     = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+    const size_t REP_CNT        = flags_objs->rep_calc_frame_cnt;
+    const size_t MAX_ATTEMPTS   = samples->capacity + BENCH_MAX_WARMUP_WINDOWS_ * STATS_WINDOW_SIZE;
+
+    frame(state, flags_objs);
+    mandelbrat2_count_workload(state->iters, state, flags_objs, workload);
+    const double PIXEL_ITERS_CNT = (double)MAX(workload->useful_iters, 1lu);
+
+    stats_ctor(&samples->stats);
+    samples->cnt = 0;
+
+    for (size_t attempt = 0; attempt < MAX_ATTEMPTS && samples->cnt < samples->capacity; ++attempt)
+    {
+        const uint64_t begin_tiks = time_checker_tsc_begin();
+        for (size_t repeat = 0; repeat < REP_CNT; ++repeat)
+        {
+            frame(state, flags_objs);
+        }
+        const uint64_t end_tiks = time_checker_tsc_end();
+
+        const double ns = time_checker_tiks_to_ns(end_tiks - begin_tiks) / (double)REP_CNT;
+
+        if (stats_push(&samples->stats, ns) != STATS_SAMPLE_ACCEPTED)
+            continue;
+
+        samples->ns_per_pixel[samples->cnt] = ns / (double)PIXELS_CNT;
+        samples->ns_per_iter [samples->cnt] = ns / PIXEL_ITERS_CNT;
+        ++samples->cnt;
+
+        if (stats_is_converged(&samples->stats, flags_objs->target_ci_rel))
+            break;
+    }
+
+    if (samples->cnt == 0)
+    {
+        for (size_t sample = 0; sample < samples->stats.window_cnt; ++sample)
+        {
+            samples->ns_per_pixel[sample] = samples->stats.window[sample] / (double)PIXELS_CNT;
+            samples->ns_per_iter [sample] = samples->stats.window[sample] / PIXEL_ITERS_CNT;
+        }
+        samples->cnt = samples->stats.window_cnt;
+    }
+}
+
+static enum BenchError run_resolution_(FILE* const out, bench_samples_t* const samples,
+                                       const flags_objs_t* const flags_objs, bool* const is_first)
+{
+    mandelbrat2_state_t state = {};
+    if (mandelbrat2_state_ctor(&state, flags_objs))
+        return BENCH_ERROR_MANDELBRAT2;
+
+    for (size_t scene = 0; scene < SCENES_CNT_; ++scene)
+    {
+        set_scene_(&state, &SCENES_[scene], flags_objs->screen_width, flags_objs->screen_height);
+
+        for (size_t kernel = 0; kernel < mandelbrat2_kernels_cnt(); ++kernel)
+        {
+            // the scenes are Mandelbrot views, other formulas there are not comparable
+            if (!mandelbrat2_kernel(kernel)->is_mandelbrot)
+                continue;
+
+            state.kernel = kernel;
+            if (mandelbrat2_state_reserve(&state, flags_objs))
+            {
+                mandelbrat2_state_dtor(&state);
+                return BENCH_ERROR_MANDELBRAT2;
+            }
+
+            mandelbrat2_workload_t workload = {};
+            measure_(samples, &state, flags_objs, compute_kernel_frame_, &workload);
+
+            const bench_summary_t per_pixel = summarize_(samples->ns_per_pixel, samples->scratch,
+                                                         samples->cnt);
+            const bench_summary_t per_iter  = summarize_(samples->ns_per_iter,  samples->scratch,
+                                                         samples->cnt);
+
+            fprintf(stdout, "%-18s %-16s %5dx%-5d %10.4f ns/pixel %8.4f ns/iter %6.2f%% lanes\n",
+                            mandelbrat2_kernel(kernel)->name, SCENES_[scene].name,
+                            flags_objs->screen_width, flags_objs->screen_height,
+                            per_pixel.median, per_iter.median, 
+                            100 * mandelbrat2_lane_utilization(&workload));
+
+            const online_stats_t* const stats = &samples->stats;
+            fprintf(out, "%s\n    {\"kernel\": \"%s\", \"scene\": \"%s\", \"width\": %d, \"height\": %d, "
+                         "\"iters_cnt\": %zu,\n     "
+                         "\"measure_cnt\": %zu, \"warmup_cnt\": %zu, \"outliers_cnt\": %zu, "
+                         "\"stationary\": %s, \"ci95_rel\": %.5f,\n     ",
+                         *is_first ? "" : ",", mandelbrat2_kernel(kernel)->name, SCENES_[scene].name,
+                         flags_objs->screen_width, flags_objs->screen_height,
+                         SCENES_[scene].iters_cnt,
+                         samples->cnt, stats->warmup_cnt, stats->outliers_cnt,
+                         stats->is_stationary ? "true" : "false", 
+                         stats->cnt > 1 ? stats_ci_rel(stats) : -1.);
+            fprint_summary_(out, "ns_per_pixel", per_pixel);
+            fprintf(out, ",\n     ");
+            fprint_summary_(out, "ns_per_iter",  per_iter);
+            fprintf(out, ",\n     ");
+            fprint_workload_(out, &workload);
+            fprintf(out, "}");
+
+            *is_first = false;
+        }
+    }
+
+    mandelbrat2_state_dtor(&state);
+
+    return BENCH_ERROR_SUCCESS;
+}
+
+static enum BenchError run_affinity_(FILE* const out, bench_samples_t* const samples,
+                                     const flags_objs_t* const flags_objs, const char* const policy,
+                                     bool* const is_first)
+{
+    flags_objs_t policy_flags = *flags_objs;
+    policy_flags.screen_width   = AFFINITY_WIDTH_;
+    policy_flags.screen_height  = AFFINITY_HEIGHT_;
+    policy_flags.use_graphics   = false;
+    policy_flags.use_resume     = false;
+    policy_flags.use_fill_check = false;
+    policy_flags.use_workload   = false;
+    policy_flags.use_buddha     = false;
+    policy_flags.tiles_filename[0] = '\0';
+    snprintf(policy_flags.affinity_policy, sizeof(policy_flags.affinity_policy), "%s", policy);
+
+    mandelbrat2_state_t state = {};
+    if (mandelbrat2_state_ctor(&state, &policy_flags))
+        return BENCH_ERROR_MANDELBRAT2;
+
+    set_scene_(&state, &SCENES_[0], policy_flags.screen_width, policy_flags.screen_height);
+
+    mandelbrat2_workload_t workload = {};
+    measure_(samples, &state, &policy_flags, compute_threaded_frame_, &workload);
+
+    const bench_summary_t per_pixel = summarize_(samples->ns_per_pixel, samples->scratch, samples->cnt);
+    const bench_summary_t per_iter  = summarize_(samples->ns_per_iter,  samples->scratch, samples->cnt);
+
+    fprintf(stdout, "%-18s %-16s %5dx%-5d %10.4f ns/pixel %8.4f ns/iter %zu threads\n",
+                    policy, SCENES_[0].name, policy_flags.screen_width, policy_flags.screen_height,
+                    per_pixel.median, per_iter.median, policy_flags.threads_cnt);
+
+    fprintf(out, "%s\n    {\"affinity\": \"%s\", \"kernel\": \"%s\", \"scene\": \"%s\", "
+                 "\"width\": %d, \"height\": %d, \"threads_cnt\": %zu,\n     \"cpus\": [",
+                 *is_first ? "" : ",", policy, mandelbrat2_kernel(state.kernel)->name, SCENES_[0].name,
+                 policy_flags.screen_width, policy_flags.screen_height, policy_flags.threads_cnt);
+    for (size_t thread = 0; thread < policy_flags.threads_cnt; ++thread)
+    {
+        fprintf(out, "%s%d", thread ? ", " : "", state.thread_cpus[thread]);
+    }
+    fprintf(out, "], \"nodes\": [");
+    for (size_t thread = 0; thread < policy_flags.threads_cnt; ++thread)
+    {
+        fprintf(out, "%s%d", thread ? ", " : "", state.thread_cpus[thread] == AFFINITY_NO_CPU ? -1 
+                                                 : affinity_cpu_node(state.thread_cpus[thread]));
+    }
+    fprintf(out, "],\n     \"measure_cnt\": %zu, \"ci95_rel\": %.5f,\n     ", samples->cnt, 
+                 samples->stats.cnt > 1 ? stats_ci_rel(&samples->stats) : -1.);
+    fprint_summary_(out, "ns_per_pixel", per_pixel);
+    fprintf(out, ",\n     ");
+    fprint_summary_(out, "ns_per_iter",  per_iter);
+    fprintf(out, "}");
+
+    *is_first = false;
+
+    mandelbrat2_state_dtor(&state);
+
+    // the policy placed the main thread as render thread 0, later stages get the mask it started with
+    if (affinity_pin(flags_objs->pin_core >= 0 ? flags_objs->pin_core : AFFINITY_NO_CPU))
+        return BENCH_ERROR_AFFINITY;
+
+    return BENCH_ERROR_SUCCESS;
+}
+
+enum BenchError bench_run(const flags_objs_t* const flags_objs)
+{
+    lassert(!is_invalid_ptr(flags_objs), "");
+
+    bench_samples_t samples = {};
+    samples.capacity = MAX(flags_objs->frame_calc_cnt ? flags_objs->frame_calc_cnt 
+                                                      : BENCH_DEFAULT_MEASURE_CNT_, 
+                           (size_t)STATS_WINDOW_SIZE);
+
+    samples.ns_per_pixel    = calloc(samples.capacity, sizeof(*samples.ns_per_pixel));
+    samples.ns_per_iter     = calloc(samples.capacity, sizeof(*samples.ns_per_iter));
+    samples.scratch         = calloc(samples.capacity, sizeof(*samples.scratch));
+    if (!samples.ns_per_pixel || !samples.ns_per_iter || !samples.scratch)
+    {
+        perror("Can't calloc bench samples");
+        free(samples.ns_per_pixel);
+        free(samples.ns_per_iter);
+        free(samples.scratch);
+        return BENCH_ERROR_STANDARD_ERRNO;
+    }
+
+    FILE* const out = fopen(flags_objs->bench_filename, "wb");
+    if (!out)
+    {
+        perror("Can't fopen bench file");
+        free(samples.ns_per_pixel);
+        free(samples.ns_per_iter);
+        free(samples.scratch);
+        return BENCH_ERROR_STANDARD_ERRNO;
+    }
+
+    fprintf(out, "{\n  \"tsc_hz\": %.0f,\n  \"max_measure_cnt\": %zu,\n  \"target_ci95_rel\": %.5f,\n"
+                 "  \"repeat_cnt\": %zu,\n  \"results\": [",
+                 time_checker_tsc_hz(), samples.capacity, flags_objs->target_ci_rel, 
+                 flags_objs->rep_calc_frame_cnt);
+
+    enum BenchError error = BENCH_ERROR_SUCCESS;
+    bool is_first = true;
+    for (size_t resolution = 0; resolution < RESOLUTIONS_CNT_ && !error; ++resolution)
+    {
+        flags_objs_t resolution_flags = *flags_objs;
+        resolution_flags.screen_width   = RESOLUTIONS_[resolution].width;
+        resolution_flags.screen_height  = RESOLUTIONS_[resolution].height;
+
+        error = run_resolution_(out, &samples, &resolution_flags, &is_first);
+    }
+
+    // -N with a core list is compared too, a named policy already is
+    const bool USE_LIST_POLICY = flags_objs->affinity_policy[0] != '\0' 
+                              && strcmp(flags_objs->affinity_policy, "none")
+                              && strcmp(flags_objs->affinity_policy, "compact")
+                              && strcmp(flags_objs->affinity_policy, "scatter");
+
+    fprintf(out, "\n  ],\n  \"affinity_results\": [");
+    is_first = true;
+    for (size_t policy = 0; policy < AFFINITY_POLICIES_CNT_ + USE_LIST_POLICY && !error; ++policy)
+    {
+        error = run_affinity_(out, &samples, flags_objs, policy < AFFINITY_POLICIES_CNT_ 
+                                                         ? AFFINITY_POLICIES_[policy] 
+                                                         : flags_objs->affinity_policy, &is_first);
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    free(samples.ns_per_pixel);
+    free(samples.ns_per_iter);
+    free(samples.scratch);
+
+    if (fclose(out))
+    {
+        perror("Can't fclose bench file");
+        return BENCH_ERROR_STANDARD_ERRNO;
+    }
+
+    return error;
+}
+#undef BENCH_MAX_WARMUP_WINDOWS_
+#undef BENCH_DEFAULT_MEASURE_CNT_
+#undef SCENES_CNT_
+#undef RESOLUTIONS_CNT_
+#undef AFFINITY_POLICIES_CNT_
+#undef AFFINITY_WIDTH_
+#undef AFFINITY_HEIGHT_
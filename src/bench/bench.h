@@ -0,0 +1,33 @@
+#ifndef BENCH_SRC_BENCH_BENCH_H
+#define BENCH_SRC_BENCH_BENCH_H
+
+#include <assert.h>
+
+#include "flags/flags.h"
+
+enum BenchError
+{
+    BENCH_ERROR_SUCCESS             = 0,
+    BENCH_ERROR_STANDARD_ERRNO      = 1,
+    BENCH_ERROR_MANDELBRAT2         = 2,
+    BENCH_ERROR_AFFINITY            = 3,
+};
+static_assert(BENCH_ERROR_SUCCESS  == 0, "");
+
+const char* bench_strerror(const enum BenchError error);
+
+#define BENCH_ERROR_HANDLE(call_func, ...)                                                          \
+    do {                                                                                            \
+        enum BenchError error_handler = call_func;                                                  \
+        if (error_handler)                                                                          \
+        {                                                                                           \
+            fprintf(stderr, "Can't " #call_func". Error: %s\n",                                     \
+                            bench_strerror(error_handler));                                         \
+            __VA_ARGS__                                                                             \
+            return error_handler;                                                                   \
+        }                                                                                           \
+    } while(0)
+
+enum BenchError bench_run(const flags_objs_t* const flags_objs);
+
+#endif /* BENCH_SRC_BENCH_BENCH_H */
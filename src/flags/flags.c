@@ -3,6 +3,7 @@
 #include <stdbool.h>
 
 #include "flags/flags.h"
+#include "affinity/affinity.h"
 #include "logger/liblogger.h"
 #include "utils/utils.h"
 
@@ -43,6 +44,13 @@ enum FlagsError flags_objs_ctor(flags_objs_t* const flags_objs)
         return FLAGS_ERROR_SUCCESS;
     }
 
+    flags_objs->bench_filename[0]   = '\0';
+    flags_objs->tiles_filename[0]   = '\0';
+    flags_objs->trace_filename[0]   = '\0';
+    flags_objs->kernel_name[0]      = '\0';
+    flags_objs->palette_name[0]     = '\0';
+    flags_objs->formula_name[0]     = '\0';
+    flags_objs->affinity_policy[0]  = '\0';
 
     flags_objs->input_file          = NULL;
 
@@ -53,8 +61,26 @@ enum FlagsError flags_objs_ctor(flags_objs_t* const flags_objs)
 
     flags_objs->use_graphics        = false;
 
+    flags_objs->pin_core            = -1;
+    flags_objs->use_perf            = false;
+    flags_objs->use_workload        = false;
+    flags_objs->threads_cnt         = 1;
+    flags_objs->escape_check_period = 4;
+    flags_objs->use_tile_order      = true;
+    flags_objs->use_symmetry        = true;
+    flags_objs->use_resume          = false;
+    flags_objs->use_auto_iters      = false;
+    flags_objs->use_fill_check      = false;
+    flags_objs->use_smooth          = false;
+    flags_objs->use_histogram       = false;
+    flags_objs->use_palette_cycle   = false;
+    flags_objs->use_buddha          = false;
+    flags_objs->use_huge_pages      = false;
+    flags_objs->antialias_threshold = 0;
+
     flags_objs->rep_calc_frame_cnt  = 1;
     flags_objs->frame_calc_cnt      = 0;
+    flags_objs->target_ci_rel       = 0;
 
     return FLAGS_ERROR_SUCCESS;
 }
@@ -81,7 +107,7 @@ enum FlagsError flags_processing(flags_objs_t* const flags_objs,
     lassert(argc, "");
 
     int getopt_rez = 0;
-    while ((getopt_rez = getopt(argc, argv, "l:o:w:h:x:y:s:r:f:c:g")) != -1)
+    while ((getopt_rez = getopt(argc, argv, "l:o:w:h:x:y:s:r:f:c:gp:eb:k:a:um:t:T:Sd:YRADzq:EP:CF:BN:H")) != -1)
     {
         switch (getopt_rez)
         {
@@ -193,6 +219,233 @@ enum FlagsError flags_processing(flags_objs_t* const flags_objs,
                 break;
             }
 
+            case 'e':
+            {
+                flags_objs->use_perf = true;
+
+                break;
+            }
+
+            case 'u':
+            {
+                flags_objs->use_workload = true;
+
+                break;
+            }
+
+            case 'b':
+            {
+                if (!strncpy(flags_objs->bench_filename, optarg, FILENAME_MAX))
+                {
+                    perror("Can't strncpy flags_objs->bench_filename");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'm':
+            {
+                if (!strncpy(flags_objs->tiles_filename, optarg, FILENAME_MAX))
+                {
+                    perror("Can't strncpy flags_objs->tiles_filename");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 't':
+            {
+                if (sscanf(optarg, "%zu", &flags_objs->threads_cnt) != 1 || !flags_objs->threads_cnt)
+                {
+                    fprintf(stderr, "Can't sscanf threads cnt\n");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'd':
+            {
+                if (sscanf(optarg, "%zu", &flags_objs->escape_check_period) != 1 
+                 || flags_objs->escape_check_period < ESCAPE_CHECK_PERIOD_MIN 
+                 || flags_objs->escape_check_period > ESCAPE_CHECK_PERIOD_MAX)
+                {
+                    fprintf(stderr, "Can't sscanf escape check period, it must be in [%d, %d]\n",
+                                    ESCAPE_CHECK_PERIOD_MIN, ESCAPE_CHECK_PERIOD_MAX);
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'Y':
+            {
+                flags_objs->use_symmetry = false;
+
+                break;
+            }
+
+            case 'H':
+            {
+                flags_objs->use_huge_pages = true;
+
+                break;
+            }
+
+            case 'N':
+            {
+                if (!affinity_is_policy(optarg))
+                {
+                    fprintf(stderr, "Unknown affinity '%s', policies: none compact scatter or a core list "
+                                    "like 0,2,8-11 with cores below %d\n", optarg, AFFINITY_MAX_CPUS);
+                    return FLAGS_ERROR_FAILURE;
+                }
+                if (!strncpy(flags_objs->affinity_policy, optarg, AFFINITY_POLICY_MAX))
+                {
+                    perror("Can't strncpy flags_objs->affinity_policy");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'B':
+            {
+                flags_objs->use_buddha = true;
+
+                break;
+            }
+
+            case 'F':
+            {
+                if (!strncpy(flags_objs->formula_name, optarg, FORMULA_NAME_MAX))
+                {
+                    perror("Can't strncpy flags_objs->formula_name");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'C':
+            {
+                flags_objs->use_palette_cycle = true;
+
+                break;
+            }
+
+            case 'P':
+            {
+                if (!strncpy(flags_objs->palette_name, optarg, PALETTE_NAME_MAX))
+                {
+                    perror("Can't strncpy flags_objs->palette_name");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'E':
+            {
+                flags_objs->use_histogram = true;
+
+                break;
+            }
+
+            case 'q':
+            {
+                if (sscanf(optarg, "%zu", &flags_objs->antialias_threshold) != 1)
+                {
+                    fprintf(stderr, "Can't sscanf antialias threshold\n");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'z':
+            {
+                flags_objs->use_smooth = true;
+
+                break;
+            }
+
+            case 'D':
+            {
+                flags_objs->use_fill_check = true;
+
+                break;
+            }
+
+            case 'A':
+            {
+                flags_objs->use_auto_iters = true;
+
+                break;
+            }
+
+            case 'R':
+            {
+                flags_objs->use_resume = true;
+
+                break;
+            }
+
+            case 'S':
+            {
+                flags_objs->use_tile_order = false;
+
+                break;
+            }
+
+            case 'T':
+            {
+                if (!strncpy(flags_objs->trace_filename, optarg, FILENAME_MAX))
+                {
+                    perror("Can't strncpy flags_objs->trace_filename");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'k':
+            {
+                if (!strncpy(flags_objs->kernel_name, optarg, KERNEL_NAME_MAX))
+                {
+                    perror("Can't strncpy flags_objs->kernel_name");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'a':
+            {
+                if (sscanf(optarg, "%lf", &flags_objs->target_ci_rel) != 1 
+                 || flags_objs->target_ci_rel < 0)
+                {
+                    fprintf(stderr, "Can't sscanf target relative confidence interval\n");
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
+            case 'p':
+            {
+                if (sscanf(optarg, "%d", &flags_objs->pin_core) != 1 || flags_objs->pin_core < 0
+                    || flags_objs->pin_core >= AFFINITY_MAX_CPUS)
+                {
+                    fprintf(stderr, "Can't sscanf pin core, it must be in [0, %d)\n", AFFINITY_MAX_CPUS);
+                    return FLAGS_ERROR_FAILURE;
+                }
+
+                break;
+            }
+
             default:
             {
                 fprintf(stderr, "Getopt error - d: %d, c: %c\n", getopt_rez, (char)getopt_rez);
@@ -201,7 +454,9 @@ enum FlagsError flags_processing(flags_objs_t* const flags_objs,
         }
     }
 
-    if (flags_objs->use_graphics && flags_objs->frame_calc_cnt != 0)
+    if ((flags_objs->use_graphics && flags_objs->frame_calc_cnt != 0)
+     || (flags_objs->use_graphics && flags_objs->bench_filename[0] != '\0')
+     || (flags_objs->use_graphics && flags_objs->target_ci_rel > 0))
     {
         fprintf(stderr, "Invalid flags combintaions\n");
         return FLAGS_ERROR_FAILURE;
@@ -33,11 +33,26 @@ enum Mode
     MODE_TEST       = 1488
 };
 
+#define KERNEL_NAME_MAX 32
+#define PALETTE_NAME_MAX 32
+#define FORMULA_NAME_MAX 32
+#define AFFINITY_POLICY_MAX 64
+
+#define ESCAPE_CHECK_PERIOD_MIN 2
+#define ESCAPE_CHECK_PERIOD_MAX 8
+
 typedef struct FlagsObjs
 {
     char log_folder         [FILENAME_MAX + 1];
     char output_filename    [FILENAME_MAX + 1];
     char font_filename      [FILENAME_MAX + 1];
+    char bench_filename     [FILENAME_MAX + 1];
+    char tiles_filename     [FILENAME_MAX + 1];
+    char trace_filename     [FILENAME_MAX + 1];
+    char kernel_name        [KERNEL_NAME_MAX + 1];
+    char palette_name       [PALETTE_NAME_MAX + 1];
+    char formula_name       [FORMULA_NAME_MAX + 1];
+    char affinity_policy    [AFFINITY_POLICY_MAX + 1];
 
     FILE* input_file;
 
@@ -48,8 +63,26 @@ typedef struct FlagsObjs
 
     bool use_graphics;
 
+    int pin_core;
+    bool use_perf;
+    bool use_workload;
+    size_t threads_cnt;
+    size_t escape_check_period;
+    bool use_tile_order;
+    bool use_symmetry;
+    bool use_resume;
+    bool use_auto_iters;
+    bool use_fill_check;
+    bool use_smooth;
+    bool use_histogram;
+    bool use_palette_cycle;
+    bool use_buddha;
+    bool use_huge_pages;
+    size_t antialias_threshold;     // 0 keeps the antialiasing off until toggled
+
     size_t rep_calc_frame_cnt;
     size_t frame_calc_cnt;
+    double target_ci_rel;
 } flags_objs_t;
 
 enum FlagsError flags_objs_ctor (flags_objs_t* const flags_objs);
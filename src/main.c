@@ -9,11 +9,14 @@
 #include "mandelbrat2/mandelbrat2.h"
 #include "sdl_objs/sdl_objs.h"
 #include "time_checker/time_checker.h"
+#include "bench/bench.h"
+#include "tracer/tracer.h"
 
 int init_all(flags_objs_t* const flags_objs, const int argc, char* const * argv, 
              sdl_objs_t* const sdl_objs,
              mandelbrat2_state_t* const state);
-int dtor_all(flags_objs_t* const flags_objs, sdl_objs_t* const sdl_objs);
+int dtor_all(flags_objs_t* const flags_objs, sdl_objs_t* const sdl_objs,
+             mandelbrat2_state_t* const state);
 
 int main(const int argc, char* const argv[])
 {
@@ -23,6 +26,14 @@ int main(const int argc, char* const argv[])
 
     INT_ERROR_HANDLE(init_all(&flags_objs, argc, argv, &sdl_objs, &state));
 
+    if (flags_objs.bench_filename[0] != '\0')
+    {
+        BENCH_ERROR_HANDLE(bench_run(&flags_objs),                 dtor_all(&flags_objs, &sdl_objs, &state););
+        INT_ERROR_HANDLE(                                            dtor_all(&flags_objs, &sdl_objs, &state););
+
+        return EXIT_SUCCESS;
+    }
+
     SDL_Event event = {};
     SDL_bool quit = SDL_FALSE;
     size_t frame_cnt = 0;
@@ -30,44 +41,62 @@ int main(const int argc, char* const argv[])
     {
         if (flags_objs.use_graphics)
         {
-            SDL_OBJS_ERROR_HANDLE(sdl_handle_events(&event, &flags_objs, &state, &quit),
-                                                                   dtor_all(&flags_objs, &sdl_objs);
+            time_checker_stage_begin(TIME_CHECKER_STAGE_EVENTS);
+            SDL_OBJS_ERROR_HANDLE(sdl_handle_events(&sdl_objs, &event, &flags_objs, &state, &quit),
+                                                                   dtor_all(&flags_objs, &sdl_objs, &state);
             );
+            time_checker_stage_end(TIME_CHECKER_STAGE_EVENTS);
 
+            time_checker_stage_begin(TIME_CHECKER_STAGE_UPLOAD);
             SDL_ERROR_HANDLE(SDL_RenderClear(sdl_objs.renderer),
-                                                                   dtor_all(&flags_objs, &sdl_objs);
+                                                                   dtor_all(&flags_objs, &sdl_objs, &state);
             );
+            time_checker_stage_end(TIME_CHECKER_STAGE_UPLOAD);
         }
 
+        time_checker_counters_begin();
         MANDELBRAT2_ERROR_HANDLE(print_frame(sdl_objs.pixels_texture, &state, &flags_objs),
-                                                                   dtor_all(&flags_objs, &sdl_objs);
+                                                                   dtor_all(&flags_objs, &sdl_objs, &state);
         );
+        time_checker_counters_end();
 
         if (flags_objs.use_graphics)
         {
+            time_checker_stage_begin(TIME_CHECKER_STAGE_UPLOAD);
             SDL_ERROR_HANDLE(SDL_RenderCopy(sdl_objs.renderer, sdl_objs.pixels_texture, NULL, NULL),
-                                                                   dtor_all(&flags_objs, &sdl_objs);
+                                                                   dtor_all(&flags_objs, &sdl_objs, &state);
             );
+            time_checker_stage_end(TIME_CHECKER_STAGE_UPLOAD);
         }
 
         TIME_CHECKER_ERROR_HANDLE(time_checker_update(&sdl_objs),
-                                                                   dtor_all(&flags_objs, &sdl_objs);
+                                                                   dtor_all(&flags_objs, &sdl_objs, &state);
         );
 
         if (flags_objs.use_graphics)
         {
+            time_checker_stage_begin(TIME_CHECKER_STAGE_PRESENT);
             SDL_RenderPresent(sdl_objs.renderer);
+            time_checker_stage_end(TIME_CHECKER_STAGE_PRESENT);
         }
 
         ++frame_cnt;
 
-        if (flags_objs.frame_calc_cnt != 0 && frame_cnt >= flags_objs.frame_calc_cnt)
+        if ((flags_objs.frame_calc_cnt != 0 && frame_cnt >= flags_objs.frame_calc_cnt)
+         || time_checker_is_converged())
         {
             quit = true;
         }
     }
 
-    INT_ERROR_HANDLE(                                            dtor_all(&flags_objs, &sdl_objs););
+    if (flags_objs.tiles_filename[0] != '\0')
+    {
+        MANDELBRAT2_ERROR_HANDLE(mandelbrat2_dump_tile_costs(&state, flags_objs.tiles_filename),
+                                                                   dtor_all(&flags_objs, &sdl_objs, &state);
+        );
+    }
+
+    INT_ERROR_HANDLE(                                            dtor_all(&flags_objs, &sdl_objs, &state););
 
     return EXIT_SUCCESS;
 }
@@ -107,13 +136,22 @@ int init_all(flags_objs_t* const flags_objs, const int argc, char* const * argv,
         );
     }
     TIME_CHECKER_ERROR_HANDLE(
-        time_checker_ctor(FPS_FREQ_MS, flags_objs->use_graphics, flags_objs->output_filename), 
+        time_checker_ctor(FPS_FREQ_MS, flags_objs->use_graphics, flags_objs->output_filename,
+                          flags_objs->pin_core, flags_objs->use_perf, flags_objs->target_ci_rel), 
                                                                         sdl_objs_dtor(sdl_objs);
                                                                     flags_objs_dtor(flags_objs);
                                                                                   logger_dtor();
     );
 
+    TRACER_ERROR_HANDLE(tracer_ctor(flags_objs->trace_filename),
+                                                                                 time_checker_dtor();
+                                                                            sdl_objs_dtor(sdl_objs);
+                                                                        flags_objs_dtor(flags_objs);
+                                                                                      logger_dtor();
+    );
+
     MANDELBRAT2_ERROR_HANDLE(mandelbrat2_state_ctor(state, flags_objs),
+                                                                                       tracer_dtor();
                                                                                  time_checker_dtor();
                                                                             sdl_objs_dtor(sdl_objs);
                                                                         flags_objs_dtor(flags_objs);
@@ -123,13 +161,17 @@ int init_all(flags_objs_t* const flags_objs, const int argc, char* const * argv,
     return EXIT_SUCCESS;
 }
 
-int dtor_all(flags_objs_t* const flags_objs, sdl_objs_t* const sdl_objs)
+int dtor_all(flags_objs_t* const flags_objs, sdl_objs_t* const sdl_objs,
+             mandelbrat2_state_t* const state)
 {
+                                                                         mandelbrat2_state_dtor(state);
+    TRACER_ERROR_HANDLE(                                                             tracer_dtor());
+    // the overlay texture of the time checker goes before its renderer
+    TIME_CHECKER_ERROR_HANDLE(                                                 time_checker_dtor());
     if (flags_objs->use_graphics)
     {
                                                                             sdl_objs_dtor(sdl_objs);
     }
-    TIME_CHECKER_ERROR_HANDLE(                                                 time_checker_dtor());
 
     LOGG_ERROR_HANDLE(                                                               logger_dtor());
     FLAGS_ERROR_HANDLE(                                                flags_objs_dtor(flags_objs));
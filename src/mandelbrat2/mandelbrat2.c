@@ -1,11 +1,19 @@
+#include <string.h>
+#include <math.h>
+#include <float.h>
 #include <xmmintrin.h>
 #include <omp.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include <SDL2/SDL.h>
 
 #include "mandelbrat2/mandelbrat2.h"
 #include "logger/liblogger.h"
 #include "utils/utils.h"
+#include "time_checker/time_checker.h"
+#include "tracer/tracer.h"
+#include "affinity/affinity.h"
 
 #define CASE_ENUM_TO_STRING_(error) case error: return #error
 const char* mandelbrat2_strerror(const enum Mandelbrat2Error error)
@@ -15,6 +23,10 @@ const char* mandelbrat2_strerror(const enum Mandelbrat2Error error)
         CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_SUCCESS);
         CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_SDL);
         CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_STANDARD_ERRNO);
+        CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_UNKNOWN_KERNEL);
+        CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_UNKNOWN_PALETTE);
+        CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_UNKNOWN_FORMULA);
+        CASE_ENUM_TO_STRING_(MANDELBRAT2_ERROR_AFFINITY);
         default:
             return "UNKNOWN_MANDELBRAT2_ERROR";
     }
@@ -36,709 +48,4059 @@ const char* mandelbrat2_strerror(const enum Mandelbrat2Error error)
 
 #include SETTINGS_FILENAME
 
+#define BUDDHA_RNG_STRIDE_ 8    // uint64_t in a cache line
+
+#ifdef __AVX2__
+#define SMOOTH_KERNEL_NAME_ "avx2_smooth"
+#else
+#define SMOOTH_KERNEL_NAME_ "scalar_smooth"
+#endif /*__AVX2__*/
+
+// formulas z -> f(z) + c besides z^2 + c, each gets scalar and avx2 kernels generated from its step,
+// one with c at the pixel and one for its Julia sets with c fixed.
+// name, symmetric about the real axis, f(-z) == f(z) so that Julia sets are symmetric about the origin
+#define FORMULA_LIST_(X)                                                                            \
+    X(multibrot3,   true,   false)                                                                  \
+    X(multibrot4,   true,   true)                                                                   \
+    X(burning_ship, false,  true)                                                                   \
+    X(tricorn,      true,   true)
+
+#ifdef __AVX2__
+#define FORMULA_KERNEL_PREFIX_ "avx2_"
+#else
+#define FORMULA_KERNEL_PREFIX_ "scalar_"
+#endif /*__AVX2__*/
+
+static const struct
+{
+    const char* name;
+    const char* kernel_name;    // NULL keeps the kernel chosen by -k
+    const char* julia_kernel_name;
+    bool is_symmetric;
+    bool is_even;
+} FORMULAS_[] = {
+    {"mandelbrot",  NULL,   FORMULA_KERNEL_PREFIX_ "julia_mandelbrot", true,   true},
+#define FORMULA_INFO_(name, is_symmetric, is_even) \
+    {#name, FORMULA_KERNEL_PREFIX_ #name, FORMULA_KERNEL_PREFIX_ "julia_" #name, is_symmetric, is_even},
+    FORMULA_LIST_(FORMULA_INFO_)
+#undef FORMULA_INFO_
+};
+#undef FORMULA_KERNEL_PREFIX_
+
+// a layout pass with no base only sums the aligned sizes
+static void* arena_take_(mandelbrat2_arena_t* const arena, const size_t size)
+{
+    void* const ptr = arena->base ? arena->base + arena->used : NULL;
+    arena->used += (size + MANDELBRAT2_ARENA_ALIGN - 1) & ~(size_t)(MANDELBRAT2_ARENA_ALIGN - 1);
+    return ptr;
+}
+
+static void layout_buffers_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_arena_t* const arena = &state->arena;
+
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+    const size_t TILES_CNT  = state->tiles_x * state->tiles_y;
+
+    arena->used = 0;
+
+    state->iters            = arena_take_(arena, PIXELS_CNT * sizeof(*state->iters));
+    state->tile_costs       = arena_take_(arena, TILES_CNT * sizeof(*state->tile_costs));
+    state->tile_costs_sum   = arena_take_(arena, TILES_CNT * sizeof(*state->tile_costs_sum));
+    state->prev_tile_costs  = arena_take_(arena, TILES_CNT * sizeof(*state->prev_tile_costs));
+    state->tile_jobs        = arena_take_(arena, TILES_CNT * sizeof(*state->tile_jobs));
+
+    if (arena->has_escape_zz)
+    {
+        state->escape_zz = arena_take_(arena, PIXELS_CNT * sizeof(*state->escape_zz));
+    }
+
+    if (arena->has_antialias)
+    {
+        state->antialias.edges  = arena_take_(arena, PIXELS_CNT * sizeof(*state->antialias.edges));
+        state->antialias.colors = arena_take_(arena, PIXELS_CNT * sizeof(*state->antialias.colors));
+    }
+
+    if (flags_objs->use_buddha)
+    {
+        const size_t GRID_SIZE = MANDELBRAT2_BUDDHA_CHANNELS * PIXELS_CNT;
+        mandelbrat2_buddha_t* const buddha = &state->buddha;
+
+        buddha->queues      = arena_take_(arena, buddha->threads_cnt * MANDELBRAT2_BUDDHA_BANDS 
+                                               * MANDELBRAT2_BUDDHA_QUEUE_SIZE * sizeof(*buddha->queues));
+        buddha->queues_cnt  = arena_take_(arena, buddha->threads_cnt * MANDELBRAT2_BUDDHA_BANDS 
+                                               * sizeof(*buddha->queues_cnt));
+        buddha->grid        = arena_take_(arena, GRID_SIZE * sizeof(*buddha->grid));
+    }
+
+    if (flags_objs->use_fill_check)
+    {
+        state->check_iters = arena_take_(arena, PIXELS_CNT * sizeof(*state->check_iters));
+    }
+
+    if (flags_objs->use_resume)
+    {
+        const size_t CAPACITY = (PIXELS_CNT + MANDELBRAT2_RESUME_BATCH - 1) 
+                              / MANDELBRAT2_RESUME_BATCH * MANDELBRAT2_RESUME_BATCH;
+        mandelbrat2_resume_t* const resume = &state->resume;
+
+        resume->pixels  = arena_take_(arena, CAPACITY * sizeof(*resume->pixels));
+        resume->x       = arena_take_(arena, CAPACITY * sizeof(*resume->x));
+        resume->y       = arena_take_(arena, CAPACITY * sizeof(*resume->y));
+        resume->x0      = arena_take_(arena, CAPACITY * sizeof(*resume->x0));
+        resume->y0      = arena_take_(arena, CAPACITY * sizeof(*resume->y0));
+    }
+}
+
+// fresh anonymous pages are zero and untouched, first_touch_ places them. With huge pages the
+// mapping is trimmed to start on a huge page boundary.
+static enum Mandelbrat2Error map_arena_(mandelbrat2_arena_t* const arena, const size_t size)
+{
+    const size_t ALIGN      = arena->use_huge_pages ? MANDELBRAT2_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    const size_t CAPACITY   = (size + ALIGN - 1) / ALIGN * ALIGN;
+    const size_t MAP_SIZE   = CAPACITY + (arena->use_huge_pages ? ALIGN : 0);
+
+    char* const map = mmap(NULL, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+    {
+        perror("Can't mmap state->arena");
+        return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+    }
+
+    char* const base = (char*)(((uintptr_t)map + ALIGN - 1) / ALIGN * ALIGN);
+    if (base != map)
+        munmap(map, (size_t)(base - map));
+    if (map + MAP_SIZE != base + CAPACITY)
+        munmap(base + CAPACITY, (size_t)(map + MAP_SIZE - (base + CAPACITY)));
+
+    if (arena->use_huge_pages && madvise(base, CAPACITY, MADV_HUGEPAGE))
+    {
+        perror("Can't madvise state->arena to huge pages");
+    }
+
+    arena->base     = base;
+    arena->capacity = CAPACITY;
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+// a reused arena holds the old frame; first_touch_ zeroes the pixel and density buffers on the
+// threads that use them, the rest is cleared here
+static void clear_unplaced_buffers_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+    const size_t TILES_CNT  = state->tiles_x * state->tiles_y;
+
+    memset(state->tile_costs,       0, TILES_CNT * sizeof(*state->tile_costs));
+    memset(state->tile_costs_sum,   0, TILES_CNT * sizeof(*state->tile_costs_sum));
+    memset(state->prev_tile_costs,  0, TILES_CNT * sizeof(*state->prev_tile_costs));
+    memset(state->tile_jobs,        0, TILES_CNT * sizeof(*state->tile_jobs));
+
+    if (state->arena.has_antialias)
+    {
+        memset(state->antialias.edges,  0, PIXELS_CNT * sizeof(*state->antialias.edges));
+        memset(state->antialias.colors, 0, PIXELS_CNT * sizeof(*state->antialias.colors));
+    }
+
+    if (flags_objs->use_resume)
+    {
+        const size_t CAPACITY = (PIXELS_CNT + MANDELBRAT2_RESUME_BATCH - 1) 
+                              / MANDELBRAT2_RESUME_BATCH * MANDELBRAT2_RESUME_BATCH;
+        mandelbrat2_resume_t* const resume = &state->resume;
+
+        memset(resume->pixels,  0, CAPACITY * sizeof(*resume->pixels));
+        memset(resume->x,       0, CAPACITY * sizeof(*resume->x));
+        memset(resume->y,       0, CAPACITY * sizeof(*resume->y));
+        memset(resume->x0,      0, CAPACITY * sizeof(*resume->x0));
+        memset(resume->y0,      0, CAPACITY * sizeof(*resume->y0));
+    }
+}
+
+// lays the buffers of flags_objs' resolution out in the arena, a smaller frame reuses it
+static enum Mandelbrat2Error map_buffers_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_arena_t* const arena = &state->arena;
+
+    state->tiles_x = ((size_t)flags_objs->screen_width  + MANDELBRAT2_TILE_SIZE - 1) / MANDELBRAT2_TILE_SIZE;
+    state->tiles_y = ((size_t)flags_objs->screen_height + MANDELBRAT2_TILE_SIZE - 1) / MANDELBRAT2_TILE_SIZE;
+
+    char* const base = arena->base;
+    arena->base = NULL;
+    layout_buffers_(state, flags_objs);
+    arena->base = base;
+
+    const bool IS_REUSED = arena->base && arena->used <= arena->capacity;
+    if (!IS_REUSED)
+    {
+        if (arena->base && munmap(arena->base, arena->capacity))
+        {
+            perror("Can't munmap state->arena");
+        }
+        arena->base = NULL;
+
+        MANDELBRAT2_ERROR_HANDLE(map_arena_(arena, arena->used));
+    }
+
+    layout_buffers_(state, flags_objs);
+    if (IS_REUSED)
+    {
+        clear_unplaced_buffers_(state, flags_objs);
+    }
+    arena->width    = flags_objs->screen_width;
+    arena->height   = flags_objs->screen_height;
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+// the frame rows and the density planes are touched in the static split colorize_frame_ and
+// colorize_buddha_ use, per-thread scratch is touched by its thread
+static void first_touch_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs, 
+                         const size_t thread)
+{
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const size_t PIXELS_CNT     = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+    #pragma omp for schedule(static)
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+    {
+        memset(state->iters     + y_screen * SCREEN_WIDTH, 0, SCREEN_WIDTH * sizeof(*state->iters));
+        if (state->escape_zz)
+            memset(state->escape_zz + y_screen * SCREEN_WIDTH, 0, SCREEN_WIDTH * sizeof(*state->escape_zz));
+        if (state->check_iters)
+            memset(state->check_iters + y_screen * SCREEN_WIDTH, 0, SCREEN_WIDTH * sizeof(*state->check_iters));
+    }
+
+    if (state->histogram.thread_bins)
+    {
+        memset(state->histogram.thread_bins + thread * MANDELBRAT2_HISTOGRAM_BINS_MAX, 0, 
+               MANDELBRAT2_HISTOGRAM_BINS_MAX * sizeof(*state->histogram.thread_bins));
+    }
+
+    mandelbrat2_buddha_t* const buddha = &state->buddha;
+    if (buddha->grid)
+    {
+        const size_t QUEUES_SIZE = MANDELBRAT2_BUDDHA_BANDS * MANDELBRAT2_BUDDHA_QUEUE_SIZE;
+
+        memset(buddha->queues + thread * QUEUES_SIZE, 0, QUEUES_SIZE * sizeof(*buddha->queues));
+        memset(buddha->queues_cnt + thread * MANDELBRAT2_BUDDHA_BANDS, 0, 
+               MANDELBRAT2_BUDDHA_BANDS * sizeof(*buddha->queues_cnt));
+        buddha->rng[thread * BUDDHA_RNG_STRIDE_] = 0x9E3779B97F4A7C15lu * (thread + 1);
+
+        for (size_t channel = 0; channel < MANDELBRAT2_BUDDHA_CHANNELS; ++channel)
+        {
+            #pragma omp for schedule(static)
+            for (size_t pixel = channel * PIXELS_CNT; pixel < (channel + 1) * PIXELS_CNT; ++pixel)
+            {
+                buddha->grid[pixel] = 0;
+            }
+        }
+    }
+}
+
+// every render thread is pinned before it first touches its pages, so they are placed on its node.
+// The openmp pool keeps the threads of a team size in the same order, later regions find them pinned.
+// Workers inherit the mask of the main thread that spawned them, -p is meant for the main thread only,
+// so it keeps the main thread, which is render thread 0, on its core whatever the policy.
+static enum Mandelbrat2Error place_threads_(mandelbrat2_state_t* const state, 
+                                            const flags_objs_t* const flags_objs)
+{
+    const size_t THREADS_CNT    = flags_objs->threads_cnt;
+    const bool   USE_PINNING    = flags_objs->affinity_policy[0] != '\0';
+    const bool   USE_PLACEMENT  = USE_PINNING || flags_objs->pin_core >= 0;
+
+    state->thread_cpus = calloc(THREADS_CNT, sizeof(*state->thread_cpus));
+    if (!state->thread_cpus)
+    {
+        perror("Can't calloc state->thread_cpus");
+        return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+    }
+
+    if (affinity_plan(USE_PINNING ? flags_objs->affinity_policy : "none", THREADS_CNT, state->thread_cpus))
+        return MANDELBRAT2_ERROR_AFFINITY;
+
+    if (flags_objs->pin_core >= 0)
+        state->thread_cpus[0] = flags_objs->pin_core;
+
+    size_t pin_errors_cnt = 0;
+
+    #pragma omp parallel num_threads((int)THREADS_CNT) reduction(+:pin_errors_cnt)
+    {
+        const size_t thread = (size_t)omp_get_thread_num();
+
+        if (USE_PLACEMENT && affinity_pin(state->thread_cpus[thread]))
+            ++pin_errors_cnt;
+
+        first_touch_(state, flags_objs, thread);
+    }
+
+    return pin_errors_cnt ? MANDELBRAT2_ERROR_AFFINITY : MANDELBRAT2_ERROR_SUCCESS;
+}
+
 enum Mandelbrat2Error mandelbrat2_state_ctor(mandelbrat2_state_t* const state, 
                                              const flags_objs_t* const flags_objs)
 {
     lassert(!is_invalid_ptr(state), "");
     lassert(!is_invalid_ptr(flags_objs), "");
 
-    state->x_offset = (float)(flags_objs->screen_width  >> 1);
-    state->y_offset = (float)(flags_objs->screen_height >> 1);
+    state->x_offset = (float)(flags_objs->screen_width  >> 1);
+    state->y_offset = (float)(flags_objs->screen_height >> 1);
+
+    state->iters_cnt = START_ITERS_CNT;
+    state->r_circle_inf = START_R_CIRCLE_INF;
+    state->scale = START_SCALE;
+    state->escape_check_period = flags_objs->escape_check_period;
+    state->resume = (mandelbrat2_resume_t){.is_valid = false};
+    state->use_auto_iters = flags_objs->use_auto_iters;
+    state->escapes_iters_cnt = 0;
+    state->check_iters = NULL;
+    state->use_smooth = flags_objs->use_smooth;
+    state->escape_zz = NULL;
+    state->palette = NULL;
+    state->palette_offset = 0;
+    state->palette_version = 0;
+    state->use_palette_cycle = flags_objs->use_palette_cycle;
+    state->frame_view = (mandelbrat2_frame_view_t){.is_valid = false};
+    state->use_antialias = flags_objs->antialias_threshold != 0;
+    state->antialias_threshold = flags_objs->antialias_threshold ? flags_objs->antialias_threshold
+                                                                 : MANDELBRAT2_ANTIALIAS_THRESHOLD;
+    state->antialias = (mandelbrat2_antialias_t){.is_valid = false};
+    state->use_histogram = flags_objs->use_histogram;
+    state->histogram = (mandelbrat2_histogram_t){.threads_cnt = flags_objs->threads_cnt};
+    state->use_buddha = flags_objs->use_buddha;
+    state->use_nebula = false;
+    state->buddha = (mandelbrat2_buddha_t){.threads_cnt = flags_objs->threads_cnt, .is_valid = false};
+    state->use_julia = false;
+    state->julia_x = 0;
+    state->julia_y = 0;
+    state->mandelbrot_scale = state->scale;
+    state->mandelbrot_x_offset = state->x_offset;
+    state->mandelbrot_y_offset = state->y_offset;
+    state->thread_cpus = NULL;
+
+    if ((state->mandelbrot_kernel = mandelbrat2_kernel_find(flags_objs->kernel_name)) == mandelbrat2_kernels_cnt())
+    {
+        fprintf(stderr, "Unknown kernel '%s', compiled kernels:", flags_objs->kernel_name);
+        for (size_t kernel = 0; kernel < mandelbrat2_kernels_cnt(); ++kernel)
+        {
+            fprintf(stderr, " %s", mandelbrat2_kernel(kernel)->name);
+        }
+        fprintf(stderr, "\n");
+        return MANDELBRAT2_ERROR_UNKNOWN_KERNEL;
+    }
+
+    if ((state->formula = mandelbrat2_formula_find(flags_objs->formula_name)) == mandelbrat2_formulas_cnt())
+    {
+        fprintf(stderr, "Unknown formula '%s', formulas:", flags_objs->formula_name);
+        for (size_t formula = 0; formula < mandelbrat2_formulas_cnt(); ++formula)
+        {
+            fprintf(stderr, " %s", mandelbrat2_formula_name(formula));
+        }
+        fprintf(stderr, "\n");
+        return MANDELBRAT2_ERROR_UNKNOWN_FORMULA;
+    }
+    mandelbrat2_set_formula(state, state->formula);
+
+    if ((state->palette_index = mandelbrat2_palette_find(flags_objs->palette_name)) == mandelbrat2_palettes_cnt())
+    {
+        fprintf(stderr, "Unknown palette '%s', palettes:", flags_objs->palette_name);
+        for (size_t palette = 0; palette < mandelbrat2_palettes_cnt(); ++palette)
+        {
+            fprintf(stderr, " %s", mandelbrat2_palette_name(palette));
+        }
+        fprintf(stderr, "\n");
+        return MANDELBRAT2_ERROR_UNKNOWN_PALETTE;
+    }
+
+    state->arena = (mandelbrat2_arena_t){
+        .base           = NULL,
+        .use_huge_pages = flags_objs->use_huge_pages,
+        .has_escape_zz  = state->use_smooth || mandelbrat2_kernel(state->kernel)->has_escape_zz,
+        .has_antialias  = flags_objs->use_graphics && state->use_antialias,
+    };
+    state->tile_costs_frames_cnt    = 0;
+    state->show_heatmap             = false;
+    state->has_prev_tile_costs      = false;
+
+    state->palette      = calloc(START_ITERS_CNT + 1, sizeof(*state->palette));
+    if (!state->palette)
+    {
+        perror("Can't calloc state->palette");
+        mandelbrat2_state_dtor(state);
+        return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+    }
+    mandelbrat2_set_palette(state, state->palette_index, 0);
+
+    if (flags_objs->use_graphics)
+    {
+        state->histogram.thread_bins    = calloc(state->histogram.threads_cnt * MANDELBRAT2_HISTOGRAM_BINS_MAX,
+                                                 sizeof(*state->histogram.thread_bins));
+        state->histogram.colors         = calloc(MANDELBRAT2_HISTOGRAM_BINS_MAX + 1, 
+                                                 sizeof(*state->histogram.colors));
+        if (!state->histogram.thread_bins || !state->histogram.colors)
+        {
+            perror("Can't calloc state histogram");
+            mandelbrat2_state_dtor(state);
+            return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+        }
+    }
+
+    if (flags_objs->use_buddha)
+    {
+        state->buddha.rng = calloc(state->buddha.threads_cnt * BUDDHA_RNG_STRIDE_, sizeof(*state->buddha.rng));
+        if (!state->buddha.rng)
+        {
+            perror("Can't calloc state->buddha.rng");
+            mandelbrat2_state_dtor(state);
+            return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+        }
+    }
+
+    MANDELBRAT2_ERROR_HANDLE(map_buffers_(state, flags_objs),
+        mandelbrat2_state_dtor(state);
+    );
+
+    MANDELBRAT2_ERROR_HANDLE(place_threads_(state, flags_objs),
+        mandelbrat2_state_dtor(state);
+    );
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+void mandelbrat2_state_dtor(mandelbrat2_state_t* const state)
+{
+    lassert(!is_invalid_ptr(state), "");
+
+    if (state->arena.base && munmap(state->arena.base, state->arena.capacity))
+    {
+        perror("Can't munmap state->arena");
+    }
+    IF_DEBUG(state->arena.base      = NULL);
+    IF_DEBUG(state->iters           = NULL);
+    IF_DEBUG(state->tile_costs      = NULL);
+    IF_DEBUG(state->tile_costs_sum  = NULL);
+    IF_DEBUG(state->prev_tile_costs = NULL);
+    IF_DEBUG(state->tile_jobs       = NULL);
+    IF_DEBUG(state->resume.pixels   = NULL);
+    IF_DEBUG(state->resume.x        = NULL);
+    IF_DEBUG(state->resume.y        = NULL);
+    IF_DEBUG(state->resume.x0       = NULL);
+    IF_DEBUG(state->resume.y0       = NULL);
+    IF_DEBUG(state->check_iters     = NULL);
+    IF_DEBUG(state->escape_zz       = NULL);
+    IF_DEBUG(state->antialias.edges     = NULL);
+    IF_DEBUG(state->antialias.colors    = NULL);
+    IF_DEBUG(state->buddha.queues       = NULL);
+    IF_DEBUG(state->buddha.queues_cnt   = NULL);
+    IF_DEBUG(state->buddha.grid         = NULL);
+
+    free(state->thread_cpus);
+    free(state->palette);
+    IF_DEBUG(state->thread_cpus     = NULL);
+    IF_DEBUG(state->palette         = NULL);
+
+    free(state->histogram.thread_bins);
+    free(state->histogram.colors);
+    IF_DEBUG(state->histogram.thread_bins   = NULL);
+    IF_DEBUG(state->histogram.colors        = NULL);
+
+    free(state->buddha.rng);
+    IF_DEBUG(state->buddha.rng          = NULL);
+}
+
+// every retained view is dropped with the old frame
+static enum Mandelbrat2Error remap_buffers_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    MANDELBRAT2_ERROR_HANDLE(map_buffers_(state, flags_objs));
+
+    #pragma omp parallel num_threads((int)flags_objs->threads_cnt)
+    first_touch_(state, flags_objs, (size_t)omp_get_thread_num());
+
+    state->tile_costs_frames_cnt    = 0;
+    state->has_prev_tile_costs      = false;
+    state->resume.is_valid          = false;
+    state->frame_view.is_valid      = false;
+    state->antialias.is_valid       = false;
+    state->antialias.edges_cnt      = 0;
+    state->antialias.done_cnt       = 0;
+    state->buddha.is_valid          = false;
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+// keeps the point at the window centre
+enum Mandelbrat2Error mandelbrat2_state_resize(mandelbrat2_state_t* const state, 
+                                               const flags_objs_t* const flags_objs)
+{
+    lassert(!is_invalid_ptr(state), "");
+    lassert(!is_invalid_ptr(flags_objs), "");
+
+    const float X_SHIFT = (float)((flags_objs->screen_width  >> 1) - (state->arena.width  >> 1));
+    const float Y_SHIFT = (float)((flags_objs->screen_height >> 1) - (state->arena.height >> 1));
+
+    MANDELBRAT2_ERROR_HANDLE(remap_buffers_(state, flags_objs));
+
+    state->x_offset             += X_SHIFT;
+    state->y_offset             += Y_SHIFT;
+    state->mandelbrot_x_offset  += X_SHIFT;
+    state->mandelbrot_y_offset  += Y_SHIFT;
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+enum Mandelbrat2Error mandelbrat2_state_reserve(mandelbrat2_state_t* const state, 
+                                                const flags_objs_t* const flags_objs)
+{
+    lassert(!is_invalid_ptr(state), "");
+    lassert(!is_invalid_ptr(flags_objs), "");
+
+    mandelbrat2_arena_t* const arena = &state->arena;
+
+    const bool USE_ESCAPE_ZZ = state->use_smooth || mandelbrat2_kernel(state->kernel)->has_escape_zz;
+    const bool USE_ANTIALIAS = flags_objs->use_graphics && state->use_antialias;
+
+    if ((!USE_ESCAPE_ZZ || arena->has_escape_zz) && (!USE_ANTIALIAS || arena->has_antialias))
+        return MANDELBRAT2_ERROR_SUCCESS;
+
+    arena->has_escape_zz |= USE_ESCAPE_ZZ;
+    arena->has_antialias |= USE_ANTIALIAS;
+
+    return remap_buffers_(state, flags_objs);
+}
+
+static mandelbrat2_rect_t tile_rect_(const size_t tile_x, const size_t tile_y, 
+                                     const flags_objs_t* const flags_objs)
+{
+    const size_t x = tile_x * MANDELBRAT2_TILE_SIZE;
+    const size_t y = tile_y * MANDELBRAT2_TILE_SIZE;
+
+    return (mandelbrat2_rect_t){
+        .x      = x,
+        .y      = y,
+        .width  = MIN((size_t)MANDELBRAT2_TILE_SIZE, (size_t)flags_objs->screen_width  - x),
+        .height = MIN((size_t)MANDELBRAT2_TILE_SIZE, (size_t)flags_objs->screen_height - y),
+    };
+}
+
+static void sift_tile_job_(mandelbrat2_tile_job_t* const jobs, const size_t jobs_cnt, size_t job)
+{
+    const mandelbrat2_tile_job_t sifted = jobs[job];
+
+    for (size_t child = 2 * job + 1; child < jobs_cnt; job = child, child = 2 * job + 1)
+    {
+        if (child + 1 < jobs_cnt && jobs[child + 1].cost < jobs[child].cost)
+            ++child;
+        if (sifted.cost <= jobs[child].cost)
+            break;
+
+        jobs[job] = jobs[child];
+    }
+    jobs[job] = sifted;
+}
+
+// heap sort with the cheapest job on top, so the array ends up longest-first; glibc qsort would
+// malloc a merge buffer every frame
+static void sort_tile_jobs_desc_(mandelbrat2_tile_job_t* const jobs, const size_t jobs_cnt)
+{
+    for (size_t job = jobs_cnt / 2; job-- > 0; )
+    {
+        sift_tile_job_(jobs, jobs_cnt, job);
+    }
+
+    for (size_t heap_cnt = jobs_cnt; heap_cnt > 1; --heap_cnt)
+    {
+        const mandelbrat2_tile_job_t cheapest = jobs[0];
+        jobs[0]             = jobs[heap_cnt - 1];
+        jobs[heap_cnt - 1]  = cheapest;
+
+        sift_tile_job_(jobs, heap_cnt - 1, 0);
+    }
+}
+
+// Predicts every tile from the last frame's tile under its centre, reprojected from the old view.
+// Tiles that were off screen get the mean cost. Sorting longest-first lets the dynamic schedule
+// hand out the heavy boundary tiles early instead of leaving one of them for the tail.
+static void order_tiles_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const size_t TILES_CNT = state->tiles_x * state->tiles_y;
+
+    for (size_t tile = 0; tile < TILES_CNT; ++tile)
+    {
+        state->tile_jobs[tile] = (mandelbrat2_tile_job_t){.cost = 0, .tile = tile};
+    }
+
+    if (!state->has_prev_tile_costs || !flags_objs->use_tile_order || flags_objs->threads_cnt == 1)
+        return;
+
+    uint64_t costs_sum = 0;
+    for (size_t tile = 0; tile < TILES_CNT; ++tile)
+    {
+        costs_sum += state->prev_tile_costs[tile];
+    }
+    const uint64_t MEAN_COST = costs_sum / TILES_CNT;
+
+    const float SCREEN_WIDTH    = (float)flags_objs->screen_width;
+    const float SCREEN_HEIGHT   = (float)flags_objs->screen_height;
+    const float SCALE_RATIO     = state->prev_scale / state->scale;
+
+    for (size_t tile = 0; tile < TILES_CNT; ++tile)
+    {
+        const mandelbrat2_rect_t rect = tile_rect_(tile % state->tiles_x, tile / state->tiles_x, flags_objs);
+
+        const float x_center = (float)rect.x + 0.5f * (float)rect.width;
+        const float y_center = (float)rect.y + 0.5f * (float)rect.height;
+        const float x_prev   = (x_center - state->x_offset) * SCALE_RATIO + state->prev_x_offset;
+        const float y_prev   = (y_center - state->y_offset) * SCALE_RATIO + state->prev_y_offset;
+
+        if (x_prev >= 0 && x_prev < SCREEN_WIDTH && y_prev >= 0 && y_prev < SCREEN_HEIGHT)
+        {
+            const size_t prev_tile = (size_t)y_prev / MANDELBRAT2_TILE_SIZE * state->tiles_x
+                                   + (size_t)x_prev / MANDELBRAT2_TILE_SIZE;
+            state->tile_jobs[tile].cost = state->prev_tile_costs[prev_tile];
+        }
+        else
+        {
+            state->tile_jobs[tile].cost = MEAN_COST;
+        }
+    }
+
+    sort_tile_jobs_desc_(state->tile_jobs, TILES_CNT);
+}
+
+// rows [copy_begin, copy_end) are copied from their mirror row axis2 - y after the compute,
+// a rotated band only in columns [copy_x_begin, copy_x_end) and from pixel axis_x2 - x of the row
+typedef struct Mandelbrat2Mirror
+{
+    bool is_rotated;
+    size_t axis2;
+    size_t copy_begin;
+    size_t copy_end;
+    size_t axis_x2;
+    size_t copy_x_begin;
+    size_t copy_x_end;
+} mandelbrat2_mirror_t;
+
+// The set is symmetric about the real axis and the kernels compute y0 as (y - y_offset) * scale,
+// which negates exactly. So row y is the exact mirror of row 2*y_offset - y when 2*y_offset is an
+// integer, a sub-pixel offset leaves no row on the mirrored pixel centres and nothing is copied.
+// Formulas whose step is not odd in y (burning ship) are not mirrored.
+// Julia sets of formulas with f(-z) == f(z) are symmetric about the origin instead, and the Julia
+// kernels compute x0 the same way, so pixel (x, y) is rotated from (2*x_offset - x, 2*y_offset - y).
+// The copied band is shrunk to whole kernel blocks, so the computed rest keeps block-aligned edges.
+static mandelbrat2_mirror_t find_mirror_(const mandelbrat2_state_t* const state, 
+                                         const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_mirror_t mirror = {.is_rotated = false, .axis2 = 0, .copy_begin = 0, .copy_end = 0,
+                                   .axis_x2 = 0, .copy_x_begin = 0, .copy_x_end = 0};
+
+    const bool  IS_ROTATED  = state->use_julia;
+    const float AXIS2       = 2 * state->y_offset;
+    const float AXIS_X2     = 2 * state->x_offset;
+    if (!flags_objs->use_symmetry 
+     || !(IS_ROTATED ? FORMULAS_[state->formula].is_even : FORMULAS_[state->formula].is_symmetric)
+     || AXIS2 < 1 || AXIS2 - floorf(AXIS2) > 0 || AXIS2 > (float)(2 * flags_objs->screen_height))
+        return mirror;
+    if (IS_ROTATED 
+     && (AXIS_X2 < 0 || AXIS_X2 - floorf(AXIS_X2) > 0 || AXIS_X2 > (float)(2 * flags_objs->screen_width)))
+        return mirror;
+
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const size_t BLOCK_HEIGHT   = mandelbrat2_kernel(state->kernel)->block_height;
+    const size_t BLOCK_WIDTH    = mandelbrat2_kernel(state->kernel)->block_width;
+
+    mirror.is_rotated   = IS_ROTATED;
+    mirror.axis2        = (size_t)AXIS2;
+
+    // upper rows whose mirror is on screen: axis2 - y < SCREEN_HEIGHT and 2y < axis2
+    const size_t first_row  = mirror.axis2 >= SCREEN_HEIGHT ? mirror.axis2 - SCREEN_HEIGHT + 1 : 0;
+    const size_t rows_end   = (mirror.axis2 + 1) / 2;
+
+    mirror.copy_begin   = (first_row + BLOCK_HEIGHT - 1) / BLOCK_HEIGHT * BLOCK_HEIGHT;
+    mirror.copy_end     = rows_end / BLOCK_HEIGHT * BLOCK_HEIGHT;
+
+    mirror.copy_x_end   = SCREEN_WIDTH;
+    if (IS_ROTATED)
+    {
+        mirror.axis_x2 = (size_t)AXIS_X2;
+
+        // columns whose rotation is on screen: 0 <= axis_x2 - x < SCREEN_WIDTH
+        const size_t first_column   = mirror.axis_x2 >= SCREEN_WIDTH ? mirror.axis_x2 - SCREEN_WIDTH + 1 : 0;
+        const size_t columns_end    = MIN(mirror.axis_x2 + 1, SCREEN_WIDTH);
+
+        mirror.copy_x_begin = (first_column + BLOCK_WIDTH - 1) / BLOCK_WIDTH * BLOCK_WIDTH;
+        mirror.copy_x_end   = columns_end / BLOCK_WIDTH * BLOCK_WIDTH;
+    }
+
+    if (mirror.copy_end <= mirror.copy_begin || mirror.copy_x_end <= mirror.copy_x_begin)
+    {
+        mirror.copy_begin = mirror.copy_end = 0;
+    }
+
+    return mirror;
+}
+
+void mandelbrat2_compute_rect(const mandelbrat2_kernel_info_t* const kernel, uint32_t* const iters,
+                              const size_t iters_pitch, const mandelbrat2_state_t* const state,
+                              const mandelbrat2_rect_t* const rect)
+{
+    lassert(!kernel->has_escape_zz || state->escape_zz, "");
+
+    const size_t BLOCKS_WIDTH   = rect->width  / kernel->block_width  * kernel->block_width;
+    const size_t BLOCKS_HEIGHT  = rect->height / kernel->block_height * kernel->block_height;
+
+    if (BLOCKS_WIDTH && BLOCKS_HEIGHT)
+    {
+        const mandelbrat2_rect_t blocks = {rect->x, rect->y, BLOCKS_WIDTH, BLOCKS_HEIGHT};
+        kernel->compute(iters, iters_pitch, state, &blocks);
+    }
+    if (BLOCKS_WIDTH < rect->width && BLOCKS_HEIGHT)
+    {
+        const mandelbrat2_rect_t right = {rect->x + BLOCKS_WIDTH, rect->y, rect->width - BLOCKS_WIDTH, 
+                                          BLOCKS_HEIGHT};
+        kernel->tail(iters, iters_pitch, state, &right);
+    }
+    if (BLOCKS_HEIGHT < rect->height)
+    {
+        const mandelbrat2_rect_t bottom = {rect->x, rect->y + BLOCKS_HEIGHT, rect->width, 
+                                           rect->height - BLOCKS_HEIGHT};
+        kernel->tail(iters, iters_pitch, state, &bottom);
+    }
+}
+
+static void compute_unmirrored_(const mandelbrat2_kernel_info_t* const kernel, uint32_t* const iters, 
+                                const size_t iters_pitch, const mandelbrat2_state_t* const state,
+                                const mandelbrat2_rect_t* const rect, 
+                                const mandelbrat2_mirror_t* const mirror)
+{
+    const size_t RECT_END       = rect->y + rect->height;
+    const size_t TOP_END        = MIN(RECT_END, MAX(rect->y, mirror->copy_begin));
+    const size_t BOTTOM_BEGIN   = MAX(rect->y, MIN(RECT_END, mirror->copy_end));
+
+    if (TOP_END > rect->y)
+    {
+        const mandelbrat2_rect_t top = {rect->x, rect->y, rect->width, TOP_END - rect->y};
+        mandelbrat2_compute_rect(kernel, iters, iters_pitch, state, &top);
+    }
+    if (BOTTOM_BEGIN < RECT_END)
+    {
+        const mandelbrat2_rect_t bottom = {rect->x, BOTTOM_BEGIN, rect->width, RECT_END - BOTTOM_BEGIN};
+        mandelbrat2_compute_rect(kernel, iters, iters_pitch, state, &bottom);
+    }
+
+    // the band columns that are not copied
+    if (BOTTOM_BEGIN > TOP_END)
+    {
+        const size_t RECT_X_END     = rect->x + rect->width;
+        const size_t LEFT_END       = MIN(RECT_X_END, MAX(rect->x, mirror->copy_x_begin));
+        const size_t RIGHT_BEGIN    = MAX(rect->x, MIN(RECT_X_END, mirror->copy_x_end));
+
+        if (LEFT_END > rect->x)
+        {
+            const mandelbrat2_rect_t left = {rect->x, TOP_END, LEFT_END - rect->x, BOTTOM_BEGIN - TOP_END};
+            mandelbrat2_compute_rect(kernel, iters, iters_pitch, state, &left);
+        }
+        if (RIGHT_BEGIN < RECT_X_END)
+        {
+            const mandelbrat2_rect_t right = {RIGHT_BEGIN, TOP_END, RECT_X_END - RIGHT_BEGIN, 
+                                              BOTTOM_BEGIN - TOP_END};
+            mandelbrat2_compute_rect(kernel, iters, iters_pitch, state, &right);
+        }
+    }
+}
+
+static void copy_mirrored_rows_(void* const rows, const size_t row_size, 
+                                const mandelbrat2_mirror_t* const mirror)
+{
+    for (size_t y_screen = mirror->copy_begin; y_screen < mirror->copy_end; ++y_screen)
+    {
+        memcpy((char*)rows + y_screen * row_size, (char*)rows + (mirror->axis2 - y_screen) * row_size, 
+               row_size);
+    }
+}
+
+static void copy_rotated_rows_(uint32_t* const iters, const size_t iters_pitch, 
+                               const mandelbrat2_mirror_t* const mirror)
+{
+    for (size_t y_screen = mirror->copy_begin; y_screen < mirror->copy_end; ++y_screen)
+    {
+        uint32_t* const row = iters + y_screen * iters_pitch;
+        const uint32_t* const mirror_row = iters + (mirror->axis2 - y_screen) * iters_pitch + mirror->axis_x2;
+
+        for (size_t x_screen = mirror->copy_x_begin; x_screen < mirror->copy_x_end; ++x_screen)
+        {
+            row[x_screen] = *(mirror_row - x_screen);
+        }
+    }
+}
+
+static void compute_tiles_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs,
+                           const mandelbrat2_kernel_info_t* const kernel, 
+                           const mandelbrat2_mirror_t* const mirror)
+{
+    const size_t ITERS_PITCH    = (size_t)flags_objs->screen_width;
+    const size_t TILES_CNT      = state->tiles_x * state->tiles_y;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads((int)flags_objs->threads_cnt)
+    for (size_t job = 0; job < TILES_CNT; ++job)
+    {
+        const size_t tile = state->tile_jobs[job].tile;
+        const mandelbrat2_rect_t rect = tile_rect_(tile % state->tiles_x, tile / state->tiles_x, flags_objs);
+
+        const uint64_t begin_tiks = time_checker_tsc_begin();
+        compute_unmirrored_(kernel, state->iters, ITERS_PITCH, state, &rect, mirror);
+        state->tile_costs[tile] += time_checker_tsc_end() - begin_tiks;
+
+        tracer_end("tile", begin_tiks, (long)tile);
+    }
+}
+
+#define RESUME_NO_PIXEL_ UINT32_MAX
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+static bool is_resumable_(const mandelbrat2_resume_t* const resume, const mandelbrat2_state_t* const state)
+{
+    return resume->is_valid && resume->iters_cnt <= state->iters_cnt
+        && resume->r_circle_inf == state->r_circle_inf && resume->scale    == state->scale
+        && resume->x_offset     == state->x_offset     && resume->y_offset == state->y_offset;
+}
+#pragma GCC diagnostic pop
+
+// the tail up to a whole batch starts outside the circle, so it escapes on the first test
+static void pad_resume_(mandelbrat2_resume_t* const resume)
+{
+    for (size_t entry = resume->cnt; entry % MANDELBRAT2_RESUME_BATCH; ++entry)
+    {
+        resume->pixels[entry]   = RESUME_NO_PIXEL_;
+        resume->x[entry]        = resume->x0[entry] = 2 * resume->r_circle_inf;
+        resume->y[entry]        = resume->y0[entry] = 0;
+    }
+}
+
+static void seed_resume_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_resume_t* const resume = &state->resume;
+
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const float  SCALE          = 1.0f / state->scale;
+    const float  X_OFFSET       = state->x_offset * SCALE;
+
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+    {
+        const float y0 = ((float)y_screen - state->y_offset) * SCALE;
+
+        for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; ++x_screen)
+        {
+            const size_t pixel = y_screen * SCREEN_WIDTH + x_screen;
+
+            resume->pixels[pixel]   = (uint32_t)pixel;
+            resume->x[pixel]        = resume->x0[pixel] = (float)x_screen * SCALE - X_OFFSET;
+            resume->y[pixel]        = resume->y0[pixel] = y0;
+        }
+    }
+
+    resume->cnt             = SCREEN_WIDTH * SCREEN_HEIGHT;
+    resume->iters_cnt       = 0;
+    resume->r_circle_inf    = state->r_circle_inf;
+    resume->scale           = state->scale;
+    resume->x_offset        = state->x_offset;
+    resume->y_offset        = state->y_offset;
+    resume->is_valid        = true;
+
+    pad_resume_(resume);
+}
+
+// continues one batch from its stored z up to iters_end, counters go on from resume->iters_cnt
+static void resume_batch_(mandelbrat2_resume_t* const resume, const size_t entry, uint32_t* const iters,
+                          const size_t iters_end)
+{
+    uint32_t batch_iters[MANDELBRAT2_RESUME_BATCH] = {};
+
+#ifdef __AVX2__
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(resume->r_circle_inf * resume->r_circle_inf);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+
+    const __m256 x0 = _mm256_loadu_ps(resume->x0 + entry);
+    const __m256 y0 = _mm256_loadu_ps(resume->y0 + entry);
+    __m256 x = _mm256_loadu_ps(resume->x + entry);
+    __m256 y = _mm256_loadu_ps(resume->y + entry);
+
+    volatile __m256 iter = _mm256_set1_ps((float)resume->iters_cnt);
+
+    for (size_t i = resume->iters_cnt; i < iters_end; ++i) {
+        __m256 xx = _mm256_mul_ps(x, x);
+        __m256 yy = _mm256_mul_ps(y, y);
+        __m256 xy = _mm256_mul_ps(x, y);
+
+        __m256 cmp = _mm256_cmp_ps(_mm256_add_ps(xx, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ); 
+
+        if (_mm256_testz_ps(cmp, cmp)) 
+            break;
+
+        iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE)); 
+        x = _mm256_add_ps(_mm256_sub_ps(xx, yy), x0);
+        y = _mm256_fmadd_ps(xy, TWO, y0);
+    }
+
+    _mm256_storeu_ps(resume->x + entry, x);
+    _mm256_storeu_ps(resume->y + entry, y);
+    _mm256_storeu_si256((__m256i*)batch_iters, _mm256_cvtps_epi32(iter));
+#else /*__AVX2__*/
+    const float R_CIRCLE_INF2 = resume->r_circle_inf * resume->r_circle_inf;
+
+    for (size_t lane = 0; lane < MANDELBRAT2_RESUME_BATCH; ++lane)
+    {
+        const float x0 = resume->x0[entry + lane];
+        const float y0 = resume->y0[entry + lane];
+        float x = resume->x[entry + lane];
+        float y = resume->y[entry + lane];
+
+        size_t iter = resume->iters_cnt;
+        for (; iter < iters_end; ++iter)
+        {
+            const float xx = x * x;
+            const float yy = y * y;
+            const float xy = x * y;
+
+            if (xx + yy > R_CIRCLE_INF2) 
+                break;
+
+            x = xx - yy + x0;
+            y = 2 * xy + y0;
+        }
+
+        resume->x[entry + lane] = x;
+        resume->y[entry + lane] = y;
+        batch_iters[lane]       = (uint32_t)iter;
+    }
+#endif /*__AVX2__*/
+
+    for (size_t lane = 0; lane < MANDELBRAT2_RESUME_BATCH; ++lane)
+    {
+        const uint32_t pixel = resume->pixels[entry + lane];
+        if (pixel != RESUME_NO_PIXEL_)
+            iters[pixel] = batch_iters[lane];
+    }
+}
+
+// keeps only the pixels that used the whole budget, the rest already have their final count
+static void compact_resume_(mandelbrat2_resume_t* const resume, const uint32_t* const iters, 
+                            const size_t iters_end)
+{
+    size_t kept = 0;
+    for (size_t entry = 0; entry < resume->cnt; ++entry)
+    {
+        const uint32_t pixel = resume->pixels[entry];
+        if (iters[pixel] != iters_end)
+            continue;
+
+        resume->pixels[kept]    = pixel;
+        resume->x[kept]         = resume->x[entry];
+        resume->y[kept]         = resume->y[entry];
+        resume->x0[kept]        = resume->x0[entry];
+        resume->y0[kept]        = resume->y0[entry];
+        ++kept;
+    }
+
+    resume->cnt         = kept;
+    resume->iters_cnt   = iters_end;
+    pad_resume_(resume);
+}
+
+// A higher budget at the same view only iterates the listed pixels on from their stored z, 
+// anything else (moved view, lower budget) starts the whole frame over from z = c.
+static void compute_resumed_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_resume_t* const resume = &state->resume;
+
+    if (!is_resumable_(resume, state))
+        seed_resume_(state, flags_objs);
+
+    if (resume->iters_cnt == state->iters_cnt)
+        return;
+
+    const uint64_t begin_tiks   = time_checker_tsc_begin();
+    const size_t ITERS_END      = state->iters_cnt;
+    const size_t ENTRIES_CNT    = resume->cnt;
+
+    #pragma omp parallel for schedule(dynamic, 64) num_threads((int)flags_objs->threads_cnt)
+    for (size_t entry = 0; entry < ENTRIES_CNT; entry += MANDELBRAT2_RESUME_BATCH)
+    {
+        resume_batch_(resume, entry, state->iters, ITERS_END);
+    }
+
+    compact_resume_(resume, state->iters, ITERS_END);
+
+    tracer_end("resume", begin_tiks, (long)ENTRIES_CNT);
+}
+#undef RESUME_NO_PIXEL_
+
+#define AUTO_ITERS_PER_OCTAVE_  32
+#define AUTO_RAISE_SHARE_       256     // more than 1/256 of the frame escaping in the upper half
+#define AUTO_LOWER_SHARE_       4096    // less than 1/4096 escaping in the upper three quarters
+
+// The zoom depth gives a floor that grows linearly with the octaves of scale. Above it the last frame
+// decides: many escapes just under the budget mean it cuts off exterior pixels, almost none in its
+// upper three quarters mean half of it is spent on the interior only. After halving, the new upper
+// half holds no more than the old upper quarters did, so the next frame doesn't raise it back.
+static void update_auto_iters_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const double OCTAVES    = log2((double)state->scale / START_SCALE);
+    const size_t FLOOR      = START_ITERS_CNT + (size_t)(AUTO_ITERS_PER_OCTAVE_ * MAX(OCTAVES, 0.));
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+
+    size_t iters_cnt = state->iters_cnt;
+    if (state->escapes_iters_cnt == state->iters_cnt)
+    {
+        if (state->escapes_upper_half_cnt * AUTO_RAISE_SHARE_ > PIXELS_CNT)
+            iters_cnt *= 2;
+        else if (state->escapes_upper_quarters_cnt * AUTO_LOWER_SHARE_ < PIXELS_CNT)
+            iters_cnt /= 2;
+    }
+
+    iters_cnt = MAX(iters_cnt, FLOOR);
+    state->iters_cnt = MIN(MAX(iters_cnt, (size_t)MANDELBRAT2_AUTO_ITERS_MIN), MANDELBRAT2_AUTO_ITERS_MAX);
+}
+#undef AUTO_ITERS_PER_OCTAVE_
+#undef AUTO_RAISE_SHARE_
+#undef AUTO_LOWER_SHARE_
+
+static void count_escapes_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const size_t   PIXELS_CNT       = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+    const uint32_t ITERS_CNT        = (uint32_t)state->iters_cnt;
+    const uint32_t UPPER_HALF       = ITERS_CNT / 2;
+    const uint32_t UPPER_QUARTERS   = ITERS_CNT / 4;
+
+    uint64_t upper_half_cnt = 0;
+    uint64_t upper_quarters_cnt = 0;
+    for (size_t pixel = 0; pixel < PIXELS_CNT; ++pixel)
+    {
+        const uint32_t iter = state->iters[pixel];
+
+        upper_half_cnt      += iter >= UPPER_HALF     && iter < ITERS_CNT;
+        upper_quarters_cnt  += iter >= UPPER_QUARTERS && iter < ITERS_CNT;
+    }
+
+    state->escapes_iters_cnt            = state->iters_cnt;
+    state->escapes_upper_half_cnt       = upper_half_cnt;
+    state->escapes_upper_quarters_cnt   = upper_quarters_cnt;
+}
+
+// iterates every pixel with the avx2 kernel, which the filling kernels match where they iterate
+static void check_fill_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+    const mandelbrat2_rect_t FRAME_RECT = {0, 0, (size_t)flags_objs->screen_width, 
+                                                 (size_t)flags_objs->screen_height};
+
+    size_t reference = mandelbrat2_kernel_find("avx2");
+    if (reference == mandelbrat2_kernels_cnt())
+        reference = mandelbrat2_kernel_find("scalar");
+
+    memcpy(state->check_iters, state->iters, PIXELS_CNT * sizeof(*state->check_iters));
+    mandelbrat2_compute_rect(mandelbrat2_kernel(reference), state->check_iters, FRAME_RECT.width, state, 
+                             &FRAME_RECT);
+
+    size_t diff_cnt = 0;
+    size_t far_cnt = 0;
+    uint32_t max_diff = 0;
+    for (size_t pixel = 0; pixel < PIXELS_CNT; ++pixel)
+    {
+        const uint32_t diff = state->iters[pixel] > state->check_iters[pixel]
+                            ? state->iters[pixel] - state->check_iters[pixel]
+                            : state->check_iters[pixel] - state->iters[pixel];
+
+        diff_cnt += diff > 0;
+        far_cnt  += diff > 1;
+        max_diff  = MAX(max_diff, diff);
+    }
+
+    fprintf(stderr, far_cnt ? YELLOW_TEXT("Fill check: %zu pixels differ, %zu by more than one, max %u\n")
+                            : "Fill check: %zu pixels differ, %zu by more than one, max %u\n",
+                    diff_cnt, far_cnt, max_diff);
+}
+
+// log scale, blue for the cheapest tile of the frame and red for the most expensive one
+static void overlay_heatmap_(Uint32* const pixels, const size_t pixels_pitch,
+                             const mandelbrat2_state_t* const state, 
+                             const flags_objs_t* const flags_objs)
+{
+    const size_t TILES_CNT = state->tiles_x * state->tiles_y;
+
+    uint64_t min_cost = UINT64_MAX;
+    uint64_t max_cost = 0;
+    for (size_t tile = 0; tile < TILES_CNT; ++tile)
+    {
+        min_cost = MIN(min_cost, MAX(state->tile_costs[tile], 1lu));
+        max_cost = MAX(max_cost, MAX(state->tile_costs[tile], 1lu));
+    }
+
+    const double log_min    = log((double)min_cost);
+    const double log_range  = MAX(log((double)max_cost) - log_min, 1e-9);
+
+    for (size_t tile_y = 0; tile_y < state->tiles_y; ++tile_y)
+    {
+        for (size_t tile_x = 0; tile_x < state->tiles_x; ++tile_x)
+        {
+            const uint64_t cost = MAX(state->tile_costs[tile_y * state->tiles_x + tile_x], 1lu);
+            const double heat   = (log((double)cost) - log_min) / log_range;
+            const Uint32 red    = (Uint32)(255 * heat);
+            const Uint32 color  = 0xFF000000 | ((255 - red) << 16) | red;
+
+            const mandelbrat2_rect_t rect = tile_rect_(tile_x, tile_y, flags_objs);
+            for (size_t y_screen = rect.y; y_screen < rect.y + rect.height; ++y_screen)
+            {
+                Uint32* const pixels_row = pixels + y_screen * pixels_pitch;
+                for (size_t x_screen = rect.x; x_screen < rect.x + rect.width; ++x_screen)
+                {
+                    pixels_row[x_screen] = ((pixels_row[x_screen] & 0xFEFEFEFE) >> 1) 
+                                         + ((color                & 0xFEFEFEFE) >> 1);
+                }
+            }
+        }
+    }
+}
+
+enum Mandelbrat2Error mandelbrat2_dump_tile_costs(const mandelbrat2_state_t* const state,
+                                                  const char* const filename)
+{
+    lassert(!is_invalid_ptr(state), "");
+    lassert(!is_invalid_ptr(filename), "");
+
+    FILE* const out = fopen(filename, "wb");
+    if (!out)
+    {
+        perror("Can't fopen tile costs file");
+        return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+    }
+
+    const double FRAMES_CNT = (double)MAX(state->tile_costs_frames_cnt, 1lu);
+
+    fprintf(out, "# tiles_x %zu tiles_y %zu tile_size %d frames %zu mean tiks per tile\n",
+                 state->tiles_x, state->tiles_y, MANDELBRAT2_TILE_SIZE, state->tile_costs_frames_cnt);
+    for (size_t tile_y = 0; tile_y < state->tiles_y; ++tile_y)
+    {
+        for (size_t tile_x = 0; tile_x < state->tiles_x; ++tile_x)
+        {
+            fprintf(out, "%s%.0f", tile_x ? " " : "", 
+                         (double)state->tile_costs_sum[tile_y * state->tiles_x + tile_x] / FRAMES_CNT);
+        }
+        fprintf(out, "\n");
+    }
+
+    if (fclose(out))
+    {
+        perror("Can't fclose tile costs file");
+        return MANDELBRAT2_ERROR_STANDARD_ERRNO;
+    }
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+// get_color marks the interior by START_ITERS_CNT, so counts are mapped onto it when the budget differs
+static Uint32 iter_color_(const mandelbrat2_state_t* const state, const size_t iter)
+{
+    return iter >= state->iters_cnt ? get_color(START_ITERS_CNT) : state->palette[MIN(iter, START_ITERS_CNT - 1)];
+}
+
+// the palette is blended between floor(nu) and the next entry, nu in [0, START_ITERS_CNT - 1]
+static Uint32 palette_lerp_(const mandelbrat2_state_t* const state, const float nu)
+{
+    const size_t index  = (size_t)nu;
+    const Uint32 weight = (Uint32)((nu - (float)index) * 128);
+    const Uint32 color0 = state->palette[index];
+    const Uint32 color1 = state->palette[index + 1];
+
+    Uint32 color = 0;
+    for (Uint32 shift = 0; shift < 32; shift += 8)
+    {
+        const int channel0 = (int)((color0 >> shift) & 0xFF);
+        const int channel1 = (int)((color1 >> shift) & 0xFF);
+        color |= (Uint32)(channel0 + (((channel1 - channel0) * (int)weight) >> 7)) << shift;
+    }
+
+    return color;
+}
+
+// nu = n + 1 - log2(log2|z|^2 / log2 R^2)
+static Uint32 smooth_color_(const mandelbrat2_state_t* const state, const size_t iter, const float escape_zz)
+{
+    if (iter >= state->iters_cnt)
+        return get_color(START_ITERS_CNT);
+
+    const float INV_LOG2_R2 = 1.0f / log2f(state->r_circle_inf * state->r_circle_inf);
+
+    const float nu = (float)iter + 1 - log2f(log2f(escape_zz) * INV_LOG2_R2);
+
+    return palette_lerp_(state, MIN(MAX(nu, 0.f), (float)(START_ITERS_CNT - 1)));
+}
+
+// valid after the histogram colouring of a frame with the same counts
+static Uint32 histogram_color_(const mandelbrat2_state_t* const state, const size_t iter)
+{
+    const mandelbrat2_histogram_t* const histogram = &state->histogram;
+
+    return histogram->colors[iter >= state->iters_cnt ? histogram->bins_cnt : iter >> histogram->shift];
+}
+
+// reads the retained counts and the palette only, so a palette change costs this pass alone
+static void colorize_frame_(Uint32* const pixels, const size_t pixels_pitch, 
+                            const mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+
+#ifdef __AVX2__
+    const __m256i ITERS_CNT_VEC     = _mm256_set1_epi32((int)MIN(state->iters_cnt, (size_t)INT32_MAX));
+    const __m256i LAST_ENTRY_VEC    = _mm256_set1_epi32((int)(START_ITERS_CNT - 1));
+    const __m256i INTERIOR_VEC      = _mm256_set1_epi32((int)get_color(START_ITERS_CNT));
+#endif /*__AVX2__*/
+
+    #pragma omp parallel for schedule(static) num_threads((int)flags_objs->threads_cnt)
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+    {
+        const uint32_t* const iters_row     = state->iters + y_screen * SCREEN_WIDTH;
+        Uint32*         const pixels_row    = pixels       + y_screen * pixels_pitch;
+
+        size_t x_screen = 0;
+
+#ifdef __AVX2__
+        for (; x_screen + 8 <= SCREEN_WIDTH; x_screen += 8)
+        {
+            const __m256i iter      = _mm256_loadu_si256((const __m256i*)(iters_row + x_screen));
+            const __m256i interior  = _mm256_cmpeq_epi32(_mm256_max_epu32(iter, ITERS_CNT_VEC), iter);
+            const __m256i color     = _mm256_i32gather_epi32((const int*)state->palette, 
+                                                             _mm256_min_epu32(iter, LAST_ENTRY_VEC), 4);
+
+            _mm256_storeu_si256((__m256i*)(pixels_row + x_screen), 
+                                _mm256_blendv_epi8(color, INTERIOR_VEC, interior));
+        }
+#endif /*__AVX2__*/
+
+        for (; x_screen < SCREEN_WIDTH; ++x_screen)
+        {
+            pixels_row[x_screen] = iter_color_(state, iters_row[x_screen]);
+        }
+    }
+}
+
+#ifdef __AVX2__
+// log2 of positive normal floats, exponent plus a degree 4 fit of log2(1 + t) on [0, 1), error 2e-4
+static __m256 log2_ps_(const __m256 x)
+{
+    const __m256i bits      = _mm256_castps_si256(x);
+    const __m256  exponent  = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), 
+                                                                  _mm256_set1_epi32(127)));
+    const __m256  t         = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(
+                                                _mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), 
+                                                _mm256_set1_epi32(0x3F800000))), 
+                                            _mm256_set1_ps(1.0f));
+
+    __m256 poly = _mm256_set1_ps(-0.0842851f);
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps( 0.3236304f));
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps(-0.6780815f));
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps( 1.4385468f));
+
+    return _mm256_fmadd_ps(poly, t, exponent);
+}
+#endif /*__AVX2__*/
+
+// smooth_color_ for 8 lanes at a time
+static void colorize_frame_smooth_(Uint32* const pixels, const size_t pixels_pitch, 
+                                   const mandelbrat2_state_t* const state, 
+                                   const flags_objs_t* const flags_objs)
+{
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+
+#ifdef __AVX2__
+    const __m256  INV_LOG2_R2_VEC   = _mm256_set1_ps(1.0f / log2f(state->r_circle_inf * state->r_circle_inf));
+    const __m256  NU_MAX_VEC        = _mm256_set1_ps((float)(START_ITERS_CNT - 1));
+    const __m256  ONE               = _mm256_set1_ps(1.0f);
+    const __m256  WEIGHT_ONE        = _mm256_set1_ps(128.0f);
+    const __m256i ITERS_CNT_VEC     = _mm256_set1_epi32((int)MIN(state->iters_cnt, (size_t)INT32_MAX));
+    const __m256i INTERIOR_VEC      = _mm256_set1_epi32((int)get_color(START_ITERS_CNT));
+    const __m256i ZERO              = _mm256_setzero_si256();
+#endif /*__AVX2__*/
+
+    #pragma omp parallel for schedule(static) num_threads((int)flags_objs->threads_cnt)
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+    {
+        const uint32_t* const iters_row     = state->iters     + y_screen * SCREEN_WIDTH;
+        const float*    const escape_zz_row = state->escape_zz + y_screen * SCREEN_WIDTH;
+        Uint32*         const pixels_row    = pixels           + y_screen * pixels_pitch;
+
+        size_t x_screen = 0;
+
+#ifdef __AVX2__
+        for (; x_screen + 8 <= SCREEN_WIDTH; x_screen += 8)
+        {
+            const __m256i iter  = _mm256_loadu_si256((const __m256i*)(iters_row + x_screen));
+            const __m256  zz    = _mm256_loadu_ps(escape_zz_row + x_screen);
+
+            __m256 nu = _mm256_add_ps(_mm256_cvtepi32_ps(iter), ONE);
+            nu = _mm256_sub_ps(nu, log2_ps_(_mm256_mul_ps(log2_ps_(zz), INV_LOG2_R2_VEC)));
+            nu = _mm256_min_ps(_mm256_max_ps(nu, _mm256_setzero_ps()), NU_MAX_VEC);
+
+            const __m256  nu_floor  = _mm256_floor_ps(nu);
+            const __m256i index     = _mm256_cvtps_epi32(nu_floor);
+            const __m256i weight    = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_sub_ps(nu, nu_floor), WEIGHT_ONE));
+            const __m256i weight16  = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+
+            const __m256i color0    = _mm256_i32gather_epi32((const int*)state->palette, index, 4);
+            const __m256i color1    = _mm256_i32gather_epi32((const int*)state->palette + 1, index, 4);
+
+            // channels as 16 bit, c0 + (c1 - c0) * w / 128 stays in range for w <= 128
+            const __m256i lo0 = _mm256_unpacklo_epi8(color0, ZERO);
+            const __m256i hi0 = _mm256_unpackhi_epi8(color0, ZERO);
+            const __m256i lo  = _mm256_add_epi16(lo0, _mm256_srai_epi16(_mm256_mullo_epi16(
+                                    _mm256_sub_epi16(_mm256_unpacklo_epi8(color1, ZERO), lo0), 
+                                    _mm256_unpacklo_epi32(weight16, weight16)), 7));
+            const __m256i hi  = _mm256_add_epi16(hi0, _mm256_srai_epi16(_mm256_mullo_epi16(
+                                    _mm256_sub_epi16(_mm256_unpackhi_epi8(color1, ZERO), hi0), 
+                                    _mm256_unpackhi_epi32(weight16, weight16)), 7));
+
+            const __m256i interior  = _mm256_cmpeq_epi32(_mm256_max_epu32(iter, ITERS_CNT_VEC), iter);
+            const __m256i color     = _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), INTERIOR_VEC, interior);
+
+            _mm256_storeu_si256((__m256i*)(pixels_row + x_screen), color);
+        }
+#endif /*__AVX2__*/
+
+        for (; x_screen < SCREEN_WIDTH; ++x_screen)
+        {
+            pixels_row[x_screen] = smooth_color_(state, iters_row[x_screen], escape_zz_row[x_screen]);
+        }
+    }
+}
+
+// counts are binned so that iters_cnt fits MANDELBRAT2_HISTOGRAM_BINS_MAX
+static void prepare_histogram_(mandelbrat2_histogram_t* const histogram, const size_t iters_cnt)
+{
+    histogram->shift = 0;
+    while (((iters_cnt - 1) >> histogram->shift) >= MANDELBRAT2_HISTOGRAM_BINS_MAX)
+        ++histogram->shift;
+
+    histogram->bins_cnt = ((iters_cnt - 1) >> histogram->shift) + 1;
+}
+
+// a bin takes the palette position of the exterior share up to and including it, so the colours
+// are spread evenly over the pixels whatever the budget is
+static void equalize_histogram_(mandelbrat2_state_t* const state)
+{
+    mandelbrat2_histogram_t* const histogram = &state->histogram;
+    const uint32_t* const bins = histogram->thread_bins;
+
+    uint64_t exterior_cnt = 0;
+    for (size_t bin = 0; bin < histogram->bins_cnt; ++bin)
+    {
+        exterior_cnt += bins[bin];
+    }
+
+    const float SPAN_PER_PIXEL = (float)state->palette_span / (float)MAX(exterior_cnt, 1lu);
+
+    uint64_t cdf = 0;
+    for (size_t bin = 0; bin < histogram->bins_cnt; ++bin)
+    {
+        cdf += bins[bin];
+        histogram->colors[bin] = palette_lerp_(state, MIN((float)cdf * SPAN_PER_PIXEL, (float)state->palette_span));
+    }
+    histogram->colors[histogram->bins_cnt] = get_color(START_ITERS_CNT);
+}
+
+// threads count their rows into private bins, sum them bin by bin into row 0, one of them takes
+// the prefix sum and all colour their rows again
+static void colorize_frame_histogram_(Uint32* const pixels, const size_t pixels_pitch, 
+                                      mandelbrat2_state_t* const state, 
+                                      const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_histogram_t* const histogram = &state->histogram;
+
+    const size_t   SCREEN_HEIGHT    = (size_t)flags_objs->screen_height;
+    const size_t   SCREEN_WIDTH     = (size_t)flags_objs->screen_width;
+    const uint32_t ITERS_CNT        = (uint32_t)state->iters_cnt;
+
+    prepare_histogram_(histogram, state->iters_cnt);
+
+    const size_t   BINS_CNT         = histogram->bins_cnt;
+    const uint32_t SHIFT            = (uint32_t)histogram->shift;
+
+    #pragma omp parallel num_threads((int)histogram->threads_cnt)
+    {
+        const size_t THREADS_CNT = (size_t)omp_get_num_threads();
+        uint32_t* const bins = histogram->thread_bins + (size_t)omp_get_thread_num() * MANDELBRAT2_HISTOGRAM_BINS_MAX;
+        memset(bins, 0, BINS_CNT * sizeof(*bins));
+
+        #pragma omp for schedule(static)
+        for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+        {
+            const uint32_t* const iters_row = state->iters + y_screen * SCREEN_WIDTH;
+            for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; ++x_screen)
+            {
+                const uint32_t iter = iters_row[x_screen];
+                if (iter < ITERS_CNT)
+                    ++bins[iter >> SHIFT];
+            }
+        }
+
+        #pragma omp for schedule(static)
+        for (size_t bin = 0; bin < BINS_CNT; ++bin)
+        {
+            uint32_t sum = 0;
+            for (size_t thread = 1; thread < THREADS_CNT; ++thread)
+            {
+                sum += histogram->thread_bins[thread * MANDELBRAT2_HISTOGRAM_BINS_MAX + bin];
+            }
+            histogram->thread_bins[bin] += sum;
+        }
+
+        #pragma omp single
+        equalize_histogram_(state);
+
+#ifdef __AVX2__
+        const __m256i ITERS_CNT_VEC = _mm256_set1_epi32((int)ITERS_CNT);
+        const __m256i BINS_CNT_VEC  = _mm256_set1_epi32((int)BINS_CNT);
+        const __m128i SHIFT_VEC     = _mm_cvtsi32_si128((int)SHIFT);
+#endif /*__AVX2__*/
+
+        #pragma omp for schedule(static)
+        for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+        {
+            const uint32_t* const iters_row  = state->iters + y_screen * SCREEN_WIDTH;
+            Uint32*         const pixels_row = pixels       + y_screen * pixels_pitch;
+
+            size_t x_screen = 0;
+
+#ifdef __AVX2__
+            for (; x_screen + 8 <= SCREEN_WIDTH; x_screen += 8)
+            {
+                const __m256i iter      = _mm256_loadu_si256((const __m256i*)(iters_row + x_screen));
+                const __m256i interior  = _mm256_cmpeq_epi32(_mm256_max_epu32(iter, ITERS_CNT_VEC), iter);
+                const __m256i bin       = _mm256_blendv_epi8(_mm256_srl_epi32(iter, SHIFT_VEC), BINS_CNT_VEC, 
+                                                             interior);
+
+                _mm256_storeu_si256((__m256i*)(pixels_row + x_screen), 
+                                    _mm256_i32gather_epi32((const int*)histogram->colors, bin, 4));
+            }
+#endif /*__AVX2__*/
+
+            for (; x_screen < SCREEN_WIDTH; ++x_screen)
+            {
+                pixels_row[x_screen] = histogram_color_(state, iters_row[x_screen]);
+            }
+        }
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+static bool is_antialias_view_(const mandelbrat2_antialias_t* const antialias, 
+                               const mandelbrat2_state_t* const state, const enum Mandelbrat2Coloring coloring)
+{
+    return antialias->is_valid && antialias->iters_cnt == state->iters_cnt 
+        && antialias->coloring     == coloring
+        && antialias->r_circle_inf == state->r_circle_inf && antialias->scale    == state->scale
+        && antialias->x_offset     == state->x_offset     && antialias->y_offset == state->y_offset;
+}
+#pragma GCC diagnostic pop
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+static bool is_frame_view_(const mandelbrat2_frame_view_t* const frame_view, 
+                           const mandelbrat2_state_t* const state, const bool use_smooth)
+{
+    return frame_view->is_valid && frame_view->iters_cnt == state->iters_cnt 
+        && (frame_view->has_escape_zz || !use_smooth) && frame_view->formula == state->formula
+        && frame_view->use_julia    == state->use_julia
+        && frame_view->julia_x      == state->julia_x      && frame_view->julia_y  == state->julia_y
+        && frame_view->r_circle_inf == state->r_circle_inf && frame_view->scale    == state->scale
+        && frame_view->x_offset     == state->x_offset     && frame_view->y_offset == state->y_offset;
+}
+#pragma GCC diagnostic pop
+
+static bool is_edge_pair_(const uint32_t first, const uint32_t second, const uint32_t iters_cnt, 
+                          const uint32_t threshold)
+{
+    return (first >= iters_cnt) != (second >= iters_cnt)
+        || (first > second ? first - second : second - first) > threshold;
+}
+
+// the right and lower neighbours are compared, a differing pair marks both of its pixels
+static void find_edges_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs, 
+                        const enum Mandelbrat2Coloring coloring)
+{
+    const size_t   SCREEN_HEIGHT    = (size_t)flags_objs->screen_height;
+    const size_t   SCREEN_WIDTH     = (size_t)flags_objs->screen_width;
+    const uint32_t ITERS_CNT        = (uint32_t)state->iters_cnt;
+    const uint32_t THRESHOLD        = (uint32_t)MIN(state->antialias_threshold, (size_t)UINT32_MAX);
+    mandelbrat2_antialias_t* const antialias = &state->antialias;
+
+    // colors is borrowed as the per pixel mark until the edges are listed
+    uint32_t* const is_edge = antialias->colors;
+    memset(is_edge, 0, SCREEN_HEIGHT * SCREEN_WIDTH * sizeof(*is_edge));
+
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+    {
+        const uint32_t* const iters_row = state->iters + y_screen * SCREEN_WIDTH;
+        uint32_t*       const is_edge_row = is_edge    + y_screen * SCREEN_WIDTH;
+
+        for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; ++x_screen)
+        {
+            if (x_screen + 1 < SCREEN_WIDTH 
+             && is_edge_pair_(iters_row[x_screen], iters_row[x_screen + 1], ITERS_CNT, THRESHOLD))
+            {
+                is_edge_row[x_screen] = is_edge_row[x_screen + 1] = 1;
+            }
+            if (y_screen + 1 < SCREEN_HEIGHT 
+             && is_edge_pair_(iters_row[x_screen], iters_row[x_screen + SCREEN_WIDTH], ITERS_CNT, THRESHOLD))
+            {
+                is_edge_row[x_screen] = is_edge_row[x_screen + SCREEN_WIDTH] = 1;
+            }
+        }
+    }
+
+    size_t edges_cnt = 0;
+    for (size_t pixel = 0; pixel < SCREEN_HEIGHT * SCREEN_WIDTH; ++pixel)
+    {
+        antialias->edges[edges_cnt] = (uint32_t)pixel;
+        edges_cnt += is_edge[pixel];
+    }
+
+    antialias->edges_cnt    = edges_cnt;
+    antialias->done_cnt     = 0;
+    antialias->is_valid     = true;
+    antialias->iters_cnt    = state->iters_cnt;
+    antialias->coloring     = coloring;
+    antialias->r_circle_inf = state->r_circle_inf;
+    antialias->scale        = state->scale;
+    antialias->x_offset     = state->x_offset;
+    antialias->y_offset     = state->y_offset;
+}
+
+// a rank-1 lattice, one sample per row and column of the 8x8 strata, shifted modulo the pixel by
+// a per pixel hash so neighbouring edges don't alias with the same pattern
+static void antialias_offsets_(const uint32_t pixel, float* const dx, float* const dy)
+{
+    uint32_t hash = pixel * 0x9E3779B1u;
+    hash ^= hash >> 15;
+    hash *= 0x85EBCA77u;
+    hash ^= hash >> 13;
+
+    const float jitter_x = (float)(hash & 0xFFFF) / 65536.f;
+    const float jitter_y = (float)(hash >> 16)    / 65536.f;
+
+    for (size_t sample = 0; sample < MANDELBRAT2_ANTIALIAS_SAMPLES; ++sample)
+    {
+        const float x = ((float)sample + 0.5f)                                     / MANDELBRAT2_ANTIALIAS_SAMPLES;
+        const float y = ((float)(sample * 5 % MANDELBRAT2_ANTIALIAS_SAMPLES) + 0.5f) / MANDELBRAT2_ANTIALIAS_SAMPLES;
+
+        dx[sample] = x + jitter_x - (x + jitter_x >= 1.f) - 0.5f;
+        dy[sample] = y + jitter_y - (y + jitter_y >= 1.f) - 0.5f;
+    }
+}
+
+#define ANTIALIAS_UNROLL_ 4
+
+// the subsamples of one pixel are the lanes of one vector, ANTIALIAS_UNROLL_ pixels are iterated
+// together as independent chains. Their colours are averaged per channel.
+static uint64_t antialias_pixels_(const mandelbrat2_state_t* const state, const uint32_t* const pixels, 
+                                  const size_t pixels_cnt, const size_t screen_width, 
+                                  const enum Mandelbrat2Coloring coloring, 
+                                  Uint32* const colors)
+{
+    static_assert(MANDELBRAT2_ANTIALIAS_SAMPLES == 8, "one subsample per avx2 float lane");
+
+    const float  SCALE      = 1.0f / state->scale;
+    const size_t ITERS_CNT  = state->iters_cnt;
+
+    float __attribute__((aligned(32))) x0[ANTIALIAS_UNROLL_][MANDELBRAT2_ANTIALIAS_SAMPLES] = {};
+    float __attribute__((aligned(32))) y0[ANTIALIAS_UNROLL_][MANDELBRAT2_ANTIALIAS_SAMPLES] = {};
+    for (size_t pixel = 0; pixel < ANTIALIAS_UNROLL_; ++pixel)
+    {
+        // missing pixels of the last batch repeat the first one
+        const uint32_t index = pixels[pixel < pixels_cnt ? pixel : 0];
+
+        antialias_offsets_(index, x0[pixel], y0[pixel]);
+        for (size_t sample = 0; sample < MANDELBRAT2_ANTIALIAS_SAMPLES; ++sample)
+        {
+            x0[pixel][sample] = ((float)(index % screen_width) + x0[pixel][sample]) * SCALE 
+                              - state->x_offset * SCALE;
+            y0[pixel][sample] = ((float)(index / screen_width) + y0[pixel][sample] - state->y_offset) * SCALE;
+        }
+    }
+
+    uint32_t __attribute__((aligned(32))) iters    [ANTIALIAS_UNROLL_][MANDELBRAT2_ANTIALIAS_SAMPLES] = {};
+    float    __attribute__((aligned(32))) escape_zz[ANTIALIAS_UNROLL_][MANDELBRAT2_ANTIALIAS_SAMPLES] = {};
+
+#ifdef __AVX2__
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+
+    __m256 x0_vec   [ANTIALIAS_UNROLL_] = {};
+    __m256 y0_vec   [ANTIALIAS_UNROLL_] = {};
+    __m256 x        [ANTIALIAS_UNROLL_] = {};
+    __m256 y        [ANTIALIAS_UNROLL_] = {};
+    __m256 iter     [ANTIALIAS_UNROLL_] = {};
+    __m256 zz_escape[ANTIALIAS_UNROLL_] = {};
+    for (size_t pixel = 0; pixel < ANTIALIAS_UNROLL_; ++pixel)
+    {
+        x[pixel] = x0_vec[pixel] = _mm256_load_ps(x0[pixel]);
+        y[pixel] = y0_vec[pixel] = _mm256_load_ps(y0[pixel]);
+        zz_escape[pixel] = _mm256_set1_ps(INFINITY);
+    }
+
+    for (size_t i = 0; i < ITERS_CNT; ++i)
+    {
+        __m256 cmp_acc = _mm256_setzero_ps();
+
+        #pragma GCC unroll 4
+        for (size_t pixel = 0; pixel < ANTIALIAS_UNROLL_; ++pixel)
+        {
+            const __m256 xx = _mm256_mul_ps(x[pixel], x[pixel]);
+            const __m256 yy = _mm256_mul_ps(y[pixel], y[pixel]);
+            const __m256 xy = _mm256_mul_ps(x[pixel], y[pixel]);
+
+            const __m256 zz  = _mm256_add_ps(xx, yy);
+            const __m256 cmp = _mm256_cmp_ps(zz, R_CIRCLE_INF2_VEC, _CMP_LE_OQ);
+
+            zz_escape[pixel] = _mm256_min_ps(_mm256_or_ps(zz, cmp), zz_escape[pixel]);
+            cmp_acc = _mm256_or_ps(cmp_acc, cmp);
+
+            iter[pixel] = _mm256_add_ps(iter[pixel], _mm256_and_ps(cmp, ONE));
+            x[pixel] = _mm256_add_ps(_mm256_sub_ps(xx, yy), x0_vec[pixel]);
+            y[pixel] = _mm256_fmadd_ps(xy, TWO, y0_vec[pixel]);
+        }
+
+        if (_mm256_testz_ps(cmp_acc, cmp_acc))
+            break;
+    }
+
+    for (size_t pixel = 0; pixel < ANTIALIAS_UNROLL_; ++pixel)
+    {
+        _mm256_store_si256((__m256i*)iters[pixel], _mm256_cvtps_epi32(iter[pixel]));
+        _mm256_store_ps(escape_zz[pixel], zz_escape[pixel]);
+    }
+
+#else /*__AVX2__*/
+    const float R_CIRCLE_INF2 = state->r_circle_inf * state->r_circle_inf;
+
+    for (size_t pixel = 0; pixel < MIN(pixels_cnt, (size_t)ANTIALIAS_UNROLL_); ++pixel)
+    {
+        for (size_t sample = 0; sample < MANDELBRAT2_ANTIALIAS_SAMPLES; ++sample)
+        {
+            size_t iter = 0;
+            escape_zz[pixel][sample] = INFINITY;
+            for (float x = x0[pixel][sample], y = y0[pixel][sample]; iter < ITERS_CNT; ++iter)
+            {
+                const float xx = x * x;
+                const float yy = y * y;
+                const float xy = x * y;
+
+                if (xx + yy > R_CIRCLE_INF2)
+                {
+                    escape_zz[pixel][sample] = xx + yy;
+                    break;
+                }
+
+                x = xx - yy + x0[pixel][sample];
+                y = 2 * xy + y0[pixel][sample];
+            }
+            iters[pixel][sample] = (uint32_t)iter;
+        }
+    }
+#endif /*__AVX2__*/
+
+    uint64_t iters_sum = 0;
+    for (size_t pixel = 0; pixel < MIN(pixels_cnt, (size_t)ANTIALIAS_UNROLL_); ++pixel)
+    {
+        Uint32 channels[4] = {};
+        for (size_t sample = 0; sample < MANDELBRAT2_ANTIALIAS_SAMPLES; ++sample)
+        {
+            Uint32 color = 0;
+            switch (coloring)
+            {
+                case MANDELBRAT2_COLORING_SMOOTH:
+                    color = smooth_color_(state, iters[pixel][sample], escape_zz[pixel][sample]);
+                    break;
+                case MANDELBRAT2_COLORING_HISTOGRAM:
+                    color = histogram_color_(state, iters[pixel][sample]);
+                    break;
+                case MANDELBRAT2_COLORING_ITERS:
+                default:
+                    color = iter_color_(state, iters[pixel][sample]);
+                    break;
+            }
+            for (size_t channel = 0; channel < 4; ++channel)
+            {
+                channels[channel] += (color >> (8 * channel)) & 0xFF;
+            }
+            iters_sum += iters[pixel][sample];
+        }
+
+        colors[pixel] = 0;
+        for (size_t channel = 0; channel < 4; ++channel)
+        {
+            colors[pixel] |= (channels[channel] / MANDELBRAT2_ANTIALIAS_SAMPLES) << (8 * channel);
+        }
+    }
+
+    return iters_sum;
+}
+
+static uint64_t refine_antialias_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_antialias_t* const antialias = &state->antialias;
+
+    const size_t BEGIN  = antialias->done_cnt;
+    const size_t END    = MIN(antialias->edges_cnt, 
+                              BEGIN + MAX(MANDELBRAT2_ANTIALIAS_ITERS_BUDGET / state->iters_cnt, (size_t)1));
+    if (BEGIN == END)
+        return 0;
+
+    const uint64_t begin_tiks   = time_checker_tsc_begin();
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const enum Mandelbrat2Coloring COLORING = antialias->coloring;
+
+    uint64_t iters_sum = 0;
+    #pragma omp parallel for schedule(dynamic, 16) num_threads((int)flags_objs->threads_cnt) reduction(+:iters_sum)
+    for (size_t edge = BEGIN; edge < END; edge += ANTIALIAS_UNROLL_)
+    {
+        iters_sum += antialias_pixels_(state, antialias->edges + edge, END - edge, SCREEN_WIDTH, COLORING, 
+                                       antialias->colors + edge);
+    }
+    antialias->done_cnt = END;
+
+    tracer_end("antialias", begin_tiks, (long)(END - BEGIN));
+
+    return iters_sum;
+}
+
+static void overlay_antialias_(Uint32* const pixels, const size_t pixels_pitch,
+                               const mandelbrat2_state_t* const state, 
+                               const flags_objs_t* const flags_objs)
+{
+    const mandelbrat2_antialias_t* const antialias = &state->antialias;
+    const size_t SCREEN_WIDTH = (size_t)flags_objs->screen_width;
+
+    for (size_t edge = 0; edge < antialias->done_cnt; ++edge)
+    {
+        const size_t pixel = antialias->edges[edge];
+        pixels[pixel / SCREEN_WIDTH * pixels_pitch + pixel % SCREEN_WIDTH] = antialias->colors[edge];
+    }
+}
+#undef ANTIALIAS_UNROLL_
+
+#define BUDDHA_LANES_ 8
+
+static uint64_t buddha_rand_(uint64_t* const rng)
+{
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    return *rng;
+}
+
+// the main cardioid and the period 2 bulb never escape, their orbits would only burn the budget,
+// and outside |c| = 2 the orbit runs away at once
+static bool is_buddha_rejected_(const float x, const float y)
+{
+    const float q = (x - 0.25f) * (x - 0.25f) + y * y;
+    return q * (q + x - 0.25f) <= 0.25f * y * y || (x + 1) * (x + 1) + y * y <= 0.0625f 
+        || x * x + y * y > 4.f;
+}
+
+// c is taken in the upper half plane only, the orbit of its conjugate is plotted mirrored
+static void sample_buddha_c_(uint64_t* const rng, float* const x0, float* const y0)
+{
+    for (size_t lane = 0; lane < BUDDHA_LANES_; ++lane)
+    {
+        do {
+            x0[lane] = (float)(buddha_rand_(rng) >> 40) * 0x1p-22f - 2.f;
+            y0[lane] = (float)(buddha_rand_(rng) >> 40) * 0x1p-23f;
+        } while (is_buddha_rejected_(x0[lane], y0[lane]));
+    }
+}
+
+// iters have the kernels' meaning, returns the vector iterations done
+static size_t escape_buddha_lanes_(const mandelbrat2_state_t* const state, const float* const x0, 
+                                   const float* const y0, uint32_t* const iters)
+{
+    const size_t ITERS_CNT = state->iters_cnt;
+
+#ifdef __AVX2__
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+
+    const __m256 x0_vec = _mm256_load_ps(x0);
+    const __m256 y0_vec = _mm256_load_ps(y0);
+
+    __m256 x    = x0_vec;
+    __m256 y    = y0_vec;
+    __m256 iter = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i < ITERS_CNT; ++i)
+    {
+        const __m256 xx = _mm256_mul_ps(x, x);
+        const __m256 yy = _mm256_mul_ps(y, y);
+        const __m256 xy = _mm256_mul_ps(x, y);
+
+        const __m256 cmp = _mm256_cmp_ps(_mm256_add_ps(xx, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);
+        if (_mm256_testz_ps(cmp, cmp))
+            break;
+
+        iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE));
+        x = _mm256_add_ps(_mm256_sub_ps(xx, yy), x0_vec);
+        y = _mm256_fmadd_ps(xy, TWO, y0_vec);
+    }
+
+    _mm256_store_si256((__m256i*)iters, _mm256_cvtps_epi32(iter));
+
+    return i;
+
+#else /*__AVX2__*/
+    const float R_CIRCLE_INF2 = state->r_circle_inf * state->r_circle_inf;
+
+    size_t vector_iters = 0;
+    for (size_t lane = 0; lane < BUDDHA_LANES_; ++lane)
+    {
+        size_t iter = 0;
+        for (float x = x0[lane], y = y0[lane]; iter < ITERS_CNT; ++iter)
+        {
+            const float xx = x * x;
+            const float yy = y * y;
+            const float xy = x * y;
+
+            if (xx + yy > R_CIRCLE_INF2)
+                break;
+
+            x = xx - yy + x0[lane];
+            y = 2 * xy + y0[lane];
+        }
+        iters[lane] = (uint32_t)iter;
+        vector_iters = MAX(vector_iters, iter + (iter < ITERS_CNT));
+    }
+
+    return vector_iters;
+#endif /*__AVX2__*/
+}
+
+// the queues of one thread, full is raised once a band has no room for the two points of a step
+typedef struct BuddhaQueues
+{
+    uint32_t* points;
+    uint32_t* cnt;
+    bool is_full;
+
+    size_t width;
+    size_t height;
+    size_t band_height;
+} buddha_queues_t;
+
+// an orbit being plotted, step is where the next round resumes it when the queues filled
+typedef struct BuddhaOrbit
+{
+    float x0;
+    float y0;
+    float x;
+    float y;
+    uint32_t step;
+    uint32_t iter;
+    size_t channels_cnt;
+} buddha_orbit_t;
+
+static void push_buddha_point_(buddha_queues_t* const queues, const size_t y_screen, const size_t x_screen, 
+                               const size_t channels_cnt)
+{
+    const size_t band = y_screen / queues->band_height;
+
+    queues->points[band * MANDELBRAT2_BUDDHA_QUEUE_SIZE + queues->cnt[band]++] 
+        = (uint32_t)((y_screen * queues->width + x_screen) << 2 | channels_cnt);
+
+    queues->is_full |= queues->cnt[band] + 2 > MANDELBRAT2_BUDDHA_QUEUE_SIZE;
+}
+
+// queues the points of the orbit until it ends or the queues fill, the latter returns false
+static bool plot_buddha_orbit_(const mandelbrat2_state_t* const state, buddha_queues_t* const queues, 
+                               buddha_orbit_t* const orbit)
+{
+    const float X0 = orbit->x0;
+    const float Y0 = orbit->y0;
+
+    float x = orbit->x;
+    float y = orbit->y;
+    for (; orbit->step < orbit->iter; ++orbit->step)
+    {
+        if (queues->is_full)
+        {
+            orbit->x = x;
+            orbit->y = y;
+            return false;
+        }
+
+        const float x_screen    = floorf(x * state->scale + state->x_offset + 0.5f);
+        const float y_screen    = floorf(y * state->scale + state->y_offset + 0.5f);
+        const float y_mirrored  = floorf(state->y_offset - y * state->scale + 0.5f);
+
+        if (x_screen >= 0 && x_screen < (float)queues->width)
+        {
+            if (y_screen >= 0 && y_screen < (float)queues->height)
+                push_buddha_point_(queues, (size_t)y_screen, (size_t)x_screen, orbit->channels_cnt);
+            if (y_mirrored >= 0 && y_mirrored < (float)queues->height && (size_t)y_mirrored != (size_t)y_screen)
+                push_buddha_point_(queues, (size_t)y_mirrored, (size_t)x_screen, orbit->channels_cnt);
+        }
+
+        const float xy = x * y;
+        x = x * x - y * y + X0;
+        y = 2 * xy + Y0;
+    }
+
+    return true;
+}
+
+// an escaped c is plotted into the channels whose limit it escaped within, none leaves iter at 0
+static buddha_orbit_t start_buddha_orbit_(const mandelbrat2_state_t* const state, const float x0, 
+                                          const float y0, const uint32_t iter)
+{
+    size_t channels_cnt = 0;
+    while (channels_cnt < MANDELBRAT2_BUDDHA_CHANNELS
+        && iter < (state->iters_cnt >> (MANDELBRAT2_BUDDHA_CHANNEL_SHIFT * channels_cnt)))
+        ++channels_cnt;
+
+    return (buddha_orbit_t){
+        .x0             = x0,
+        .y0             = y0,
+        .x              = x0,
+        .y              = y0,
+        .step           = 0,
+        .iter           = channels_cnt && iter >= MANDELBRAT2_BUDDHA_MIN_ITERS ? iter : 0,
+        .channels_cnt   = channels_cnt,
+    };
+}
+
+// the band's queues of every thread, only the thread that owns the band this round writes its rows
+static void merge_buddha_band_(mandelbrat2_buddha_t* const buddha, const size_t band, const size_t threads_cnt,
+                               const size_t pixels_cnt, uint64_t* const max)
+{
+    for (size_t thread = 0; thread < threads_cnt; ++thread)
+    {
+        uint32_t* const cnt = buddha->queues_cnt + thread * MANDELBRAT2_BUDDHA_BANDS + band;
+        const uint32_t* const points = buddha->queues 
+                                     + (thread * MANDELBRAT2_BUDDHA_BANDS + band) * MANDELBRAT2_BUDDHA_QUEUE_SIZE;
+
+        for (size_t point = 0; point < *cnt; ++point)
+        {
+            const size_t pixel          = points[point] >> 2;
+            const size_t channels_cnt   = points[point] & 3;
+
+            for (size_t channel = 0; channel < channels_cnt; ++channel)
+            {
+                const uint64_t grid_cnt = ++buddha->grid[channel * pixels_cnt + pixel];
+                max[channel] = MAX(max[channel], grid_cnt);
+            }
+        }
+
+        *cnt = 0;
+    }
+}
+
+// every thread samples until it has spent MANDELBRAT2_BUDDHA_ITERS_BUDGET; a round ends when one of
+// its queues fills, the orbit it was plotting is resumed after the merge
+static void sample_buddha_(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs, 
+                           uint64_t* const samples_cnt, uint64_t* const iters_cnt)
+{
+    mandelbrat2_buddha_t* const buddha = &state->buddha;
+
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t PIXELS_CNT     = SCREEN_WIDTH * SCREEN_HEIGHT;
+    const uint32_t ITERS_CNT    = (uint32_t)state->iters_cnt;
+
+    lassert(PIXELS_CNT <= (UINT32_MAX >> 2), "");
+
+    uint64_t samples_sum = 0;
+    uint64_t iters_sum   = 0;
+    size_t sampling_cnt  = 0;
+    bool is_sampling     = true;
+
+    #pragma omp parallel num_threads((int)buddha->threads_cnt) reduction(+:samples_sum, iters_sum)
+    {
+        const size_t thread         = (size_t)omp_get_thread_num();
+        const size_t TEAM_SIZE      = (size_t)omp_get_num_threads();
+        uint64_t* const rng         = buddha->rng + thread * BUDDHA_RNG_STRIDE_;
+
+        buddha_queues_t queues = {
+            .points         = buddha->queues + thread * MANDELBRAT2_BUDDHA_BANDS * MANDELBRAT2_BUDDHA_QUEUE_SIZE,
+            .cnt            = buddha->queues_cnt + thread * MANDELBRAT2_BUDDHA_BANDS,
+            .is_full        = false,
+            .width          = SCREEN_WIDTH,
+            .height         = SCREEN_HEIGHT,
+            .band_height    = (SCREEN_HEIGHT + MANDELBRAT2_BUDDHA_BANDS - 1) / MANDELBRAT2_BUDDHA_BANDS,
+        };
+
+        float    __attribute__((aligned(32))) x0   [BUDDHA_LANES_] = {};
+        float    __attribute__((aligned(32))) y0   [BUDDHA_LANES_] = {};
+        uint32_t __attribute__((aligned(32))) iters[BUDDHA_LANES_] = {};
+
+        buddha_orbit_t orbit        = {};
+        size_t lane                 = BUDDHA_LANES_;
+        size_t vector_iters         = 0;
+        bool is_done                = false;
+        uint64_t max[MANDELBRAT2_BUDDHA_CHANNELS] = {};
+
+        #pragma omp atomic
+        ++sampling_cnt;
+        #pragma omp barrier
+
+        while (is_sampling)
+        {
+            queues.is_full = false;
+            while (!is_done)
+            {
+                if (orbit.step < orbit.iter)
+                {
+                    if (!plot_buddha_orbit_(state, &queues, &orbit))
+                        break;
+                }
+                else if (lane < BUDDHA_LANES_)
+                {
+                    if (iters[lane] < ITERS_CNT)
+                        orbit = start_buddha_orbit_(state, x0[lane], y0[lane], iters[lane]);
+                    ++lane;
+                }
+                else if (vector_iters < MANDELBRAT2_BUDDHA_ITERS_BUDGET)
+                {
+                    sample_buddha_c_(rng, x0, y0);
+                    vector_iters += escape_buddha_lanes_(state, x0, y0, iters);
+
+                    for (size_t new_lane = 0; new_lane < BUDDHA_LANES_; ++new_lane)
+                    {
+                        iters_sum += iters[new_lane];
+                    }
+                    samples_sum += BUDDHA_LANES_;
+                    lane = 0;
+                }
+                else
+                {
+                    is_done = true;
+                    #pragma omp atomic
+                    --sampling_cnt;
+                }
+            }
+
+            #pragma omp barrier
+
+            #pragma omp for schedule(static)
+            for (size_t band = 0; band < MANDELBRAT2_BUDDHA_BANDS; ++band)
+            {
+                merge_buddha_band_(buddha, band, TEAM_SIZE, PIXELS_CNT, max);
+            }
+
+            #pragma omp single
+            is_sampling = sampling_cnt != 0;
+        }
+
+        #pragma omp critical
+        for (size_t channel = 0; channel < MANDELBRAT2_BUDDHA_CHANNELS; ++channel)
+        {
+            buddha->max[channel] = MAX(buddha->max[channel], max[channel]);
+        }
+    }
+
+    *samples_cnt += samples_sum;
+    *iters_cnt   += iters_sum;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+static bool is_buddha_view_(const mandelbrat2_buddha_t* const buddha, const mandelbrat2_state_t* const state)
+{
+    return buddha->is_valid
+        && buddha->iters_cnt    == state->iters_cnt
+        && buddha->r_circle_inf == state->r_circle_inf
+        && buddha->scale        == state->scale
+        && buddha->x_offset     == state->x_offset
+        && buddha->y_offset     == state->y_offset;
+}
+#pragma GCC diagnostic pop
+
+static void reset_buddha_(mandelbrat2_buddha_t* const buddha, const mandelbrat2_state_t* const state, 
+                          const size_t pixels_cnt)
+{
+    memset(buddha->grid, 0, MANDELBRAT2_BUDDHA_CHANNELS * pixels_cnt * sizeof(*buddha->grid));
+    memset(buddha->max,  0, sizeof(buddha->max));
+
+    buddha->samples_cnt     = 0;
+    buddha->is_valid        = true;
+    buddha->iters_cnt       = state->iters_cnt;
+    buddha->r_circle_inf    = state->r_circle_inf;
+    buddha->scale           = state->scale;
+    buddha->x_offset        = state->x_offset;
+    buddha->y_offset        = state->y_offset;
+}
+
+// square root of the density, a few pixels on the orbits' attractors outshine everything linearly
+static void colorize_buddha_(Uint32* const pixels, const size_t pixels_pitch, 
+                             const mandelbrat2_state_t* const state, 
+                             const flags_objs_t* const flags_objs)
+{
+    const mandelbrat2_buddha_t* const buddha = &state->buddha;
+
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const size_t PIXELS_CNT     = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+    float inv_max[MANDELBRAT2_BUDDHA_CHANNELS] = {};
+    for (size_t channel = 0; channel < MANDELBRAT2_BUDDHA_CHANNELS; ++channel)
+    {
+        inv_max[channel] = 1.f / (float)MAX(buddha->max[channel], 1lu);
+    }
+
+    #pragma omp parallel for schedule(static) num_threads((int)flags_objs->threads_cnt)
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+    {
+        Uint32* const pixels_row = pixels + y_screen * pixels_pitch;
+
+        for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; ++x_screen)
+        {
+            const size_t pixel = y_screen * SCREEN_WIDTH + x_screen;
+
+            Uint32 channels[MANDELBRAT2_BUDDHA_CHANNELS] = {};
+            for (size_t channel = 0; channel < MANDELBRAT2_BUDDHA_CHANNELS; ++channel)
+            {
+                channels[channel] = (Uint32)(255 * sqrtf((float)buddha->grid[channel * PIXELS_CNT + pixel] 
+                                                         * inv_max[channel]));
+            }
+
+            pixels_row[x_screen] = state->use_nebula 
+                                 ? 0xFF000000 | channels[0] << 16 | channels[1] << 8 | channels[2]
+                                 : 0xFF000000 | channels[0] << 16 | channels[0] << 8 | channels[0];
+        }
+    }
+}
+
+// the density keeps growing while the view stays, every frame adds a budget of samples to it
+static enum Mandelbrat2Error print_buddha_frame_(SDL_Texture* pixels_texture, 
+                                                 mandelbrat2_state_t* const state,
+                                                 const flags_objs_t* const flags_objs)
+{
+    mandelbrat2_buddha_t* const buddha = &state->buddha;
+
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+
+    if (!is_buddha_view_(buddha, state))
+    {
+        reset_buddha_(buddha, state, PIXELS_CNT);
+    }
+
+    uint64_t samples_cnt = 0;
+    uint64_t iters_cnt   = 0;
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_COMPUTE);
+    for (size_t repeat = 0; repeat < flags_objs->rep_calc_frame_cnt; ++repeat)
+    {
+        sample_buddha_(state, flags_objs, &samples_cnt, &iters_cnt);
+    }
+    time_checker_stage_end(TIME_CHECKER_STAGE_COMPUTE);
+
+    buddha->samples_cnt += samples_cnt;
+    time_checker_set_workload(samples_cnt, iters_cnt);
+    time_checker_set_samples(samples_cnt);
+
+    if (!flags_objs->use_graphics)
+    {
+        return MANDELBRAT2_ERROR_SUCCESS;
+    }
+
+    void *pixels_void = NULL;
+    int pitch = 0;
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_UPLOAD);
+    SDL_ERROR_HANDLE_(SDL_LockTexture(pixels_texture, NULL, &pixels_void, &pitch));
+    time_checker_stage_end(TIME_CHECKER_STAGE_UPLOAD);
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_COLORIZE);
+    colorize_buddha_((Uint32*)pixels_void, (size_t)(pitch >> 2), state, flags_objs);
+    time_checker_stage_end(TIME_CHECKER_STAGE_COLORIZE);
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_UPLOAD);
+    SDL_UnlockTexture(pixels_texture);
+    time_checker_stage_end(TIME_CHECKER_STAGE_UPLOAD);
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+#undef BUDDHA_LANES_
+
+static uint64_t sum_iters_(const uint32_t* const iters, const flags_objs_t* const flags_objs)
+{
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+
+    uint64_t sum = 0;
+    for (size_t pixel = 0; pixel < PIXELS_CNT; ++pixel)
+    {
+        sum += iters[pixel];
+    }
+
+    return sum;
+}
+
+enum Mandelbrat2Error print_frame(SDL_Texture* pixels_texture, 
+                                  mandelbrat2_state_t* const state,
+                                  const flags_objs_t* const flags_objs)
+{
+    if (flags_objs->use_graphics)
+    {
+        lassert(!is_invalid_ptr(pixels_texture), "");
+    }   
+    lassert(!is_invalid_ptr(state), "");
+    lassert(!is_invalid_ptr(flags_objs), "");
+
+    MANDELBRAT2_ERROR_HANDLE(mandelbrat2_state_reserve(state, flags_objs));
+
+    if (state->use_buddha)
+    {
+        return print_buddha_frame_(pixels_texture, state, flags_objs);
+    }
+
+    if (state->use_auto_iters)
+    {
+        update_auto_iters_(state, flags_objs);
+    }
+
+    if (state->use_palette_cycle)
+    {
+        mandelbrat2_set_palette(state, state->palette_index, state->palette_offset + 1);
+    }
+
+    if (state->antialias.palette_version != state->palette_version)
+    {
+        state->antialias.done_cnt           = 0;
+        state->antialias.palette_version    = state->palette_version;
+    }
+
+    // the resumed orbits, the escape |z|^2 and the subsamples all iterate z^2 + c with c at the pixel
+    const bool IS_MANDELBROT = state->formula == MANDELBRAT2_FORMULA_MANDELBROT && !state->use_julia;
+    if (!IS_MANDELBROT)
+    {
+        state->resume.is_valid = false;
+    }
+
+    const bool USE_RESUME   = flags_objs->use_resume && IS_MANDELBROT;
+    const bool USE_SMOOTH   = !USE_RESUME && IS_MANDELBROT && state->use_smooth && !state->use_histogram;
+    const enum Mandelbrat2Coloring COLORING = state->use_histogram ? MANDELBRAT2_COLORING_HISTOGRAM 
+                                            : USE_SMOOTH           ? MANDELBRAT2_COLORING_SMOOTH 
+                                                                   : MANDELBRAT2_COLORING_ITERS;
+    const mandelbrat2_kernel_info_t* const KERNEL = mandelbrat2_kernel(USE_SMOOTH 
+                                                                     ? mandelbrat2_kernel_find(SMOOTH_KERNEL_NAME_)
+                                                                     : state->kernel);
+    const mandelbrat2_rect_t FRAME_RECT = {0, 0, (size_t)flags_objs->screen_width, 
+                                                 (size_t)flags_objs->screen_height};
+    const bool USE_ANTIALIAS    = !USE_RESUME && IS_MANDELBROT && flags_objs->use_graphics 
+                               && state->use_antialias;
+    const bool REFINE_ANTIALIAS = USE_ANTIALIAS && !state->use_palette_cycle 
+                               && is_antialias_view_(&state->antialias, state, COLORING);
+    const bool RECOLOR_ONLY     = flags_objs->use_graphics && !REFINE_ANTIALIAS 
+                               && state->frame_view.palette_version != state->palette_version
+                               && is_frame_view_(&state->frame_view, state, USE_SMOOTH);
+    const bool SKIP_COMPUTE     = REFINE_ANTIALIAS || RECOLOR_ONLY;
+    const bool USE_COMPUTE      = !USE_RESUME && !SKIP_COMPUTE;
+    const bool RECORD_TILES = USE_COMPUTE && (state->show_heatmap || flags_objs->tiles_filename[0] != '\0');
+    const bool USE_TILES    = USE_COMPUTE && (RECORD_TILES || flags_objs->threads_cnt > 1 
+                                                           || tracer_is_enabled());
+    const size_t TILES_CNT  = state->tiles_x * state->tiles_y;
+    const mandelbrat2_mirror_t MIRROR = find_mirror_(state, flags_objs);
+
+    if (USE_TILES)
+    {
+        memset(state->tile_costs, 0, TILES_CNT * sizeof(*state->tile_costs));
+        order_tiles_(state, flags_objs);
+    }
+
+    const size_t ANTIALIAS_DONE_CNT = state->antialias.done_cnt;
+    uint64_t antialias_iters = 0;
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_COMPUTE);
+    for (size_t repeat = 0; repeat < flags_objs->rep_calc_frame_cnt; ++repeat)
+    {
+        if (SKIP_COMPUTE)
+        {
+            if (REFINE_ANTIALIAS)
+                antialias_iters = refine_antialias_(state, flags_objs);
+            break;
+        }
+
+        if (USE_RESUME)
+        {
+            compute_resumed_(state, flags_objs);
+            continue;
+        }
+
+        if (USE_TILES)
+            compute_tiles_(state, flags_objs, KERNEL, &MIRROR);
+        else
+            compute_unmirrored_(KERNEL, state->iters, FRAME_RECT.width, state, &FRAME_RECT, &MIRROR);
+
+        if (MIRROR.is_rotated)
+            copy_rotated_rows_(state->iters, FRAME_RECT.width, &MIRROR);
+        else
+            copy_mirrored_rows_(state->iters, FRAME_RECT.width * sizeof(*state->iters), &MIRROR);
+        if (USE_SMOOTH)
+            copy_mirrored_rows_(state->escape_zz, FRAME_RECT.width * sizeof(*state->escape_zz), &MIRROR);
+    }
+    time_checker_stage_end(TIME_CHECKER_STAGE_COMPUTE);
+
+    if (!SKIP_COMPUTE)
+    {
+        state->frame_view = (mandelbrat2_frame_view_t){
+            .is_valid       = true,
+            .iters_cnt      = state->iters_cnt,
+            .r_circle_inf   = state->r_circle_inf,
+            .scale          = state->scale,
+            .x_offset       = state->x_offset,
+            .y_offset       = state->y_offset,
+            .has_escape_zz  = USE_SMOOTH,
+            .formula        = state->formula,
+            .use_julia      = state->use_julia,
+            .julia_x        = state->julia_x,
+            .julia_y        = state->julia_y,
+            .palette_version = state->palette_version,
+        };
+    }
+
+    if (USE_ANTIALIAS && !SKIP_COMPUTE)
+    {
+        find_edges_(state, flags_objs, COLORING);
+    }
+    else if (!USE_ANTIALIAS)
+    {
+        state->antialias.is_valid = false;
+    }
+
+    if (state->use_auto_iters && !SKIP_COMPUTE)
+    {
+        count_escapes_(state, flags_objs);
+    }
+
+    if (flags_objs->use_fill_check && IS_MANDELBROT && !SKIP_COMPUTE)
+    {
+        check_fill_(state, flags_objs);
+    }
+
+    if (USE_TILES)
+    {
+        memcpy(state->prev_tile_costs, state->tile_costs, TILES_CNT * sizeof(*state->prev_tile_costs));
+        state->has_prev_tile_costs  = true;
+        state->prev_scale           = state->scale;
+        state->prev_x_offset        = state->x_offset;
+        state->prev_y_offset        = state->y_offset;
+    }
+
+    if (RECORD_TILES)
+    {
+        for (size_t tile = 0; tile < TILES_CNT; ++tile)
+        {
+            state->tile_costs_sum[tile] += state->tile_costs[tile];
+        }
+        ++state->tile_costs_frames_cnt;
+    }
+
+    const size_t REP_CNT    = flags_objs->rep_calc_frame_cnt;
+    const size_t PIXELS_CNT = (size_t)flags_objs->screen_width * (size_t)flags_objs->screen_height;
+    if (SKIP_COMPUTE)
+    {
+        time_checker_set_workload((state->antialias.done_cnt - ANTIALIAS_DONE_CNT) * MANDELBRAT2_ANTIALIAS_SAMPLES, 
+                                  antialias_iters);
+    }
+    else if (flags_objs->use_workload)
+    {
+        mandelbrat2_workload_t workload = {};
+        mandelbrat2_count_workload(state->iters, state, flags_objs, &workload);
+
+        time_checker_set_workload(PIXELS_CNT * REP_CNT, workload.useful_iters * REP_CNT);
+        time_checker_set_workload_details(&workload);
+    }
+    else
+    {
+        time_checker_set_workload(PIXELS_CNT * REP_CNT, sum_iters_(state->iters, flags_objs) * REP_CNT);
+    }
+
+    if (!flags_objs->use_graphics)
+    {
+        return MANDELBRAT2_ERROR_SUCCESS;
+    }
+
+    void *pixels_void = NULL;
+    int pitch = 0;
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_UPLOAD);
+    SDL_ERROR_HANDLE_(SDL_LockTexture(pixels_texture, NULL, &pixels_void, &pitch));
+    time_checker_stage_end(TIME_CHECKER_STAGE_UPLOAD);
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_COLORIZE);
+    switch (COLORING)
+    {
+        case MANDELBRAT2_COLORING_SMOOTH:
+            colorize_frame_smooth_   ((Uint32*)pixels_void, (size_t)(pitch >> 2), state, flags_objs);
+            break;
+        case MANDELBRAT2_COLORING_HISTOGRAM:
+            colorize_frame_histogram_((Uint32*)pixels_void, (size_t)(pitch >> 2), state, flags_objs);
+            break;
+        case MANDELBRAT2_COLORING_ITERS:
+        default:
+            colorize_frame_          ((Uint32*)pixels_void, (size_t)(pitch >> 2), state, flags_objs);
+            break;
+    }
+    if (USE_ANTIALIAS)
+    {
+        overlay_antialias_((Uint32*)pixels_void, (size_t)(pitch >> 2), state, flags_objs);
+    }
+    if ((RECORD_TILES || SKIP_COMPUTE) && state->show_heatmap)
+    {
+        overlay_heatmap_((Uint32*)pixels_void, (size_t)(pitch >> 2), state, flags_objs);
+    }
+    state->frame_view.palette_version = state->palette_version;
+    time_checker_stage_end(TIME_CHECKER_STAGE_COLORIZE);
+
+    time_checker_stage_begin(TIME_CHECKER_STAGE_UPLOAD);
+    SDL_UnlockTexture(pixels_texture);
+    time_checker_stage_end(TIME_CHECKER_STAGE_UPLOAD);
+
+    return MANDELBRAT2_ERROR_SUCCESS;
+}
+
+static void compute_frame_scalar_(uint32_t* const iters, const size_t iters_pitch,
+                                  const mandelbrat2_state_t* const state,
+                                  const mandelbrat2_rect_t* const rect)
+{
+    const double    R_CIRCLE_INF2   = state->r_circle_inf*state->r_circle_inf;
+    const double    SCALE           = 1 / state->scale;
+    const size_t    ITERS_CNT       = state->iters_cnt;
+
+// #ifdef COMPILE_OPTIMIZED
+// #pragma omp parallel for collapse(1) schedule(guided)
+// #endif /*COMPILE_OPTIMIZED*/
+
+    for (size_t y_screen = rect->y; y_screen < rect->y + rect->height; ++y_screen)
+    {
+        const double y0 = ((double)y_screen - state->y_offset) * SCALE;
+
+        for (size_t x_screen = rect->x; x_screen < rect->x + rect->width; ++x_screen)
+        {
+            const double x0 = ((double)x_screen - state->x_offset) * SCALE;
+
+            volatile size_t iter = 0;
+            for (double x = x0, y = y0; iter < ITERS_CNT; ++iter)
+            {
+                const double xx = x * x;
+                const double yy = y * y;
+                const double xy = x * y;
+
+                if (xx + yy > R_CIRCLE_INF2) 
+                    break;
+                
+                x = xx - yy + x0;
+                y = 2 * xy + y0;
+            }
+
+            iters[y_screen * iters_pitch + x_screen] = (uint32_t)iter;
+        }
+    }
+}
+
+// also writes |z|^2 of the first step outside the circle to state->escape_zz
+static void compute_frame_scalar_smooth_(uint32_t* const iters, const size_t iters_pitch,
+                                         const mandelbrat2_state_t* const state,
+                                         const mandelbrat2_rect_t* const rect)
+{
+    const double    R_CIRCLE_INF2   = state->r_circle_inf*state->r_circle_inf;
+    const double    SCALE           = 1 / state->scale;
+    const size_t    ITERS_CNT       = state->iters_cnt;
+
+    for (size_t y_screen = rect->y; y_screen < rect->y + rect->height; ++y_screen)
+    {
+        const double y0 = ((double)y_screen - state->y_offset) * SCALE;
+
+        for (size_t x_screen = rect->x; x_screen < rect->x + rect->width; ++x_screen)
+        {
+            const double x0 = ((double)x_screen - state->x_offset) * SCALE;
+
+            volatile size_t iter = 0;
+            double escape_zz = INFINITY;
+            for (double x = x0, y = y0; iter < ITERS_CNT; ++iter)
+            {
+                const double xx = x * x;
+                const double yy = y * y;
+                const double xy = x * y;
+
+                if (xx + yy > R_CIRCLE_INF2) 
+                {
+                    escape_zz = xx + yy;
+                    break;
+                }
+                
+                x = xx - yy + x0;
+                y = 2 * xy + y0;
+            }
+
+            iters           [y_screen * iters_pitch + x_screen] = (uint32_t)iter;
+            state->escape_zz[y_screen * iters_pitch + x_screen] = (float)escape_zz;
+        }
+    }
+}
+
+// z -> f(z) + c of the formulas, xx and yy are the squares the escape test used
+#define FORMULA_STEP_mandelbrot_(x, y, xx, yy, c_x, c_y)                                            \
+    do {                                                                                            \
+        y = 2 * x * y + c_y;                                                                        \
+        x = xx - yy + c_x;                                                                          \
+    } while(0)
+
+#define FORMULA_STEP_multibrot3_(x, y, xx, yy, c_x, c_y)                                            \
+    do {                                                                                            \
+        const double x_ = x * (xx - 3 * yy) + c_x;                                                  \
+        y = y * (3 * xx - yy) + c_y;                                                                \
+        x = x_;                                                                                     \
+    } while(0)
+
+#define FORMULA_STEP_multibrot4_(x, y, xx, yy, c_x, c_y)                                            \
+    do {                                                                                            \
+        const double re_ = xx - yy;                                                                 \
+        const double im_ = 2 * x * y;                                                               \
+        x = re_ * re_ - im_ * im_ + c_x;                                                            \
+        y = 2 * re_ * im_ + c_y;                                                                    \
+    } while(0)
+
+#define FORMULA_STEP_burning_ship_(x, y, xx, yy, c_x, c_y)                                          \
+    do {                                                                                            \
+        y = 2 * fabs(x * y) + c_y;                                                                  \
+        x = xx - yy + c_x;                                                                          \
+    } while(0)
+
+#define FORMULA_STEP_tricorn_(x, y, xx, yy, c_x, c_y)                                               \
+    do {                                                                                            \
+        y = -2 * x * y + c_y;                                                                       \
+        x = xx - yy + c_x;                                                                          \
+    } while(0)
+
+// compute_frame_scalar_ with the step pasted in, z starts at the pixel and c is (c_x, c_y)
+#define FORMULA_KERNEL_SCALAR_(kernel, step, prologue, c_x, c_y)                                    \
+static void kernel(uint32_t* const iters, const size_t iters_pitch,                                 \
+                   const mandelbrat2_state_t* const state,                                          \
+                   const mandelbrat2_rect_t* const rect)                                            \
+{                                                                                                   \
+    const double    R_CIRCLE_INF2   = state->r_circle_inf*state->r_circle_inf;                      \
+    const double    SCALE           = 1 / state->scale;                                             \
+    const size_t    ITERS_CNT       = state->iters_cnt;                                             \
+    prologue                                                                                        \
+                                                                                                    \
+    for (size_t y_screen = rect->y; y_screen < rect->y + rect->height; ++y_screen)                  \
+    {                                                                                               \
+        const double y0 = ((double)y_screen - state->y_offset) * SCALE;                             \
+                                                                                                    \
+        for (size_t x_screen = rect->x; x_screen < rect->x + rect->width; ++x_screen)               \
+        {                                                                                           \
+            const double x0 = ((double)x_screen - state->x_offset) * SCALE;                         \
+                                                                                                    \
+            volatile size_t iter = 0;                                                               \
+            for (double x = x0, y = y0; iter < ITERS_CNT; ++iter)                                   \
+            {                                                                                       \
+                const double xx = x * x;                                                            \
+                const double yy = y * y;                                                            \
+                                                                                                    \
+                if (xx + yy > R_CIRCLE_INF2)                                                        \
+                    break;                                                                          \
+                                                                                                    \
+                step(x, y, xx, yy, c_x, c_y);                                                       \
+            }                                                                                       \
+                                                                                                    \
+            iters[y_screen * iters_pitch + x_screen] = (uint32_t)iter;                              \
+        }                                                                                           \
+    }                                                                                               \
+}
+
+#define FORMULA_JULIA_PROLOGUE_SCALAR_                                                              \
+    const double JULIA_X = state->julia_x;                                                          \
+    const double JULIA_Y = state->julia_y;
+
+#define FORMULA_KERNELS_SCALAR_(name, is_symmetric, is_even)                                        \
+    FORMULA_KERNEL_SCALAR_(compute_frame_scalar_##name##_, FORMULA_STEP_##name##_, , x0, y0)        \
+    FORMULA_KERNEL_SCALAR_(compute_frame_scalar_julia_##name##_, FORMULA_STEP_##name##_,            \
+                           FORMULA_JULIA_PROLOGUE_SCALAR_, JULIA_X, JULIA_Y)
+
+FORMULA_LIST_(FORMULA_KERNELS_SCALAR_)
+// z^2 + c with c at the pixel is the hand-written kernels, only its Julia kernel is generated
+FORMULA_KERNEL_SCALAR_(compute_frame_scalar_julia_mandelbrot_, FORMULA_STEP_mandelbrot_, 
+                       FORMULA_JULIA_PROLOGUE_SCALAR_, JULIA_X, JULIA_Y)
+#undef FORMULA_KERNELS_SCALAR_
+#undef FORMULA_JULIA_PROLOGUE_SCALAR_
+#undef FORMULA_KERNEL_SCALAR_
+#undef FORMULA_STEP_mandelbrot_
+#undef FORMULA_STEP_multibrot3_
+#undef FORMULA_STEP_multibrot4_
+#undef FORMULA_STEP_burning_ship_
+#undef FORMULA_STEP_tricorn_
+
+#ifdef __AVX2__
+
+#define Y0_CTOR4_                                                                                   \
+    __m256 y01 = _mm256_set1_ps(((float)y_screen - state->y_offset) * SCALE);                      \
+    __m256 y02 = y01;                                                                               \
+    __m256 y03 = y01;                                                                               \
+    __m256 y04 = y01;
+
+#define X0_CTOR4_                                                                                   \
+    __m256 x01 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*0));                   \
+    __m256 x02 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*1));                   \
+    __m256 x03 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*2));                   \
+    __m256 x04 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*3));                   \
+           x01 = _mm256_sub_ps(_mm256_mul_ps(x01, SCALE_VEC), X_OFFSET);                            \
+           x02 = _mm256_sub_ps(_mm256_mul_ps(x02, SCALE_VEC), X_OFFSET);                            \
+           x03 = _mm256_sub_ps(_mm256_mul_ps(x03, SCALE_VEC), X_OFFSET);                            \
+           x04 = _mm256_sub_ps(_mm256_mul_ps(x04, SCALE_VEC), X_OFFSET);                            
+
+#define ITER_CTOR4_                                                                                 \
+    volatile __m256 iter1 = _mm256_setzero_ps();                                                    \
+    volatile __m256 iter2 = _mm256_setzero_ps();                                                    \
+    volatile __m256 iter3 = _mm256_setzero_ps();                                                    \
+    volatile __m256 iter4 = _mm256_setzero_ps();                                                             
+
+#define X_CTOR4_                                                                                    \
+    __m256 x1 = x01;                                                                                \
+    __m256 x2 = x02;                                                                                \
+    __m256 x3 = x03;                                                                                \
+    __m256 x4 = x04;                                                                                
+
+#define Y_CTOR4_                                                                                    \
+    __m256 y1 = y01;                                                                                \
+    __m256 y2 = y02;                                                                                \
+    __m256 y3 = y03;                                                                                \
+    __m256 y4 = y04;                                                                                
+
+#define XX_CTOR4_                                                                                   \
+    __m256 xx1 = _mm256_mul_ps(x1, x1);                                                             \
+    __m256 xx2 = _mm256_mul_ps(x2, x2);                                                             \
+    __m256 xx3 = _mm256_mul_ps(x3, x3);                                                             \
+    __m256 xx4 = _mm256_mul_ps(x4, x4);                                                             
+
+#define YY_CTOR4_                                                                                   \
+    __m256 yy1 = _mm256_mul_ps(y1, y1);                                                             \
+    __m256 yy2 = _mm256_mul_ps(y2, y2);                                                             \
+    __m256 yy3 = _mm256_mul_ps(y3, y3);                                                             \
+    __m256 yy4 = _mm256_mul_ps(y4, y4);                                                             
+
+#define XY_CTOR4_                                                                                   \
+    __m256 xy1 = _mm256_mul_ps(x1, y1);                                                             \
+    __m256 xy2 = _mm256_mul_ps(x2, y2);                                                             \
+    __m256 xy3 = _mm256_mul_ps(x3, y3);                                                             \
+    __m256 xy4 = _mm256_mul_ps(x4, y4);                                                             
+
+#define CMP_CTOR4_                                                                                  \
+    __m256 cmp1 = _mm256_cmp_ps(_mm256_add_ps(xx1, yy1), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);            \
+    __m256 cmp2 = _mm256_cmp_ps(_mm256_add_ps(xx2, yy2), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);            \
+    __m256 cmp3 = _mm256_cmp_ps(_mm256_add_ps(xx3, yy3), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);            \
+    __m256 cmp4 = _mm256_cmp_ps(_mm256_add_ps(xx4, yy4), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);  
+
+#define CHECK_CMP4_                                                                                 \
+    (                                                                                               \
+        _mm256_testz_ps(cmp1, cmp1)                                                                 \
+     && _mm256_testz_ps(cmp2, cmp2)                                                                 \
+     && _mm256_testz_ps(cmp3, cmp3)                                                                 \
+     && _mm256_testz_ps(cmp4, cmp4)                                                                 \
+    )
+
+#define UPDATE_ITER4_                                                                               \
+    iter1 = _mm256_add_ps(iter1, _mm256_and_ps(cmp1, ONE));                                         \
+    iter2 = _mm256_add_ps(iter2, _mm256_and_ps(cmp2, ONE));                                         \
+    iter3 = _mm256_add_ps(iter3, _mm256_and_ps(cmp3, ONE));                                         \
+    iter4 = _mm256_add_ps(iter4, _mm256_and_ps(cmp4, ONE));
+
+#define UPDATE_X4_                                                                                  \
+    x1 = _mm256_add_ps(_mm256_sub_ps(xx1, yy1), x01);                                               \
+    x2 = _mm256_add_ps(_mm256_sub_ps(xx2, yy2), x02);                                               \
+    x3 = _mm256_add_ps(_mm256_sub_ps(xx3, yy3), x03);                                               \
+    x4 = _mm256_add_ps(_mm256_sub_ps(xx4, yy4), x04);
+
+#define UPDATE_Y4_                                                                                  \
+    y1 = _mm256_fmadd_ps(xy1, TWO, y01);                                                            \
+    y2 = _mm256_fmadd_ps(xy2, TWO, y02);                                                            \
+    y3 = _mm256_fmadd_ps(xy3, TWO, y03);                                                            \
+    y4 = _mm256_fmadd_ps(xy4, TWO, y04);
+
+
+#ifndef __aligned
+#define __aligned __attribute__((aligned(32)))
+#endif
+
+#define STORE_ITER4_                                                                                \
+    _mm256_storeu_si256((__m256i*)(iters_row + x_screen + 8*0), _mm256_cvtps_epi32(iter1));       \
+    _mm256_storeu_si256((__m256i*)(iters_row + x_screen + 8*1), _mm256_cvtps_epi32(iter2));       \
+    _mm256_storeu_si256((__m256i*)(iters_row + x_screen + 8*2), _mm256_cvtps_epi32(iter3));       \
+    _mm256_storeu_si256((__m256i*)(iters_row + x_screen + 8*3), _mm256_cvtps_epi32(iter4));
+
+#define UNROLL_CNT 4
+#define SIMD_OBJS_CNT 8 
+static void compute_frame_avx2_unroll4_(uint32_t* const iters, const size_t iters_pitch,
+                                        const mandelbrat2_state_t* const state,
+                                        const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
+
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
+    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+// #ifdef COMPILE_OPTIMIZED
+// #pragma omp parallel for collapse(1) schedule(guided)
+// #endif /*COMPILE_OPTIMIZED*/
+
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        Y0_CTOR4_
+
+        uint32_t* const iters_row = iters + y_screen * ITERS_PITCH;
+
+        for (size_t x_screen = rect->x; x_screen + SIMD_OBJS_CNT*UNROLL_CNT <= X_END; 
+                    x_screen += SIMD_OBJS_CNT*UNROLL_CNT)
+        {
+            X0_CTOR4_
+            
+            ITER_CTOR4_
+            X_CTOR4_
+            Y_CTOR4_
+
+            for (size_t i = 0; i < ITERS_CNT; ++i) {
+                XX_CTOR4_
+                YY_CTOR4_
+                XY_CTOR4_
+                
+                CMP_CTOR4_
+
+                if (CHECK_CMP4_) 
+                    break;
+                
+                UPDATE_ITER4_
+                UPDATE_X4_
+                UPDATE_Y4_
+            }
+
+            STORE_ITER4_
+        }
+    }
+}
+#undef UNROLL_CNT
+#undef SIMD_OBJS_CNT
+
+#define SIMD_OBJS_CNT 8 
+static void compute_frame_avx2_(uint32_t* const iters, const size_t iters_pitch,
+                                const mandelbrat2_state_t* const state,
+                                const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
+
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
+    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+// #ifdef COMPILE_OPTIMIZED
+// #pragma omp parallel for collapse(1) schedule(guided)
+// #endif /*COMPILE_OPTIMIZED*/
+
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        __m256 y0 = _mm256_set1_ps(((float)y_screen - state->y_offset) * SCALE);
+
+        uint32_t* const iters_row = iters + y_screen * ITERS_PITCH;
+
+        for (size_t x_screen = rect->x; x_screen + SIMD_OBJS_CNT <= X_END; x_screen += SIMD_OBJS_CNT)
+        {
+            __m256 x0 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*0));
+                   x0 = _mm256_fmsub_ps(x0, SCALE_VEC, X_OFFSET); 
+            
+            volatile __m256 iter = _mm256_setzero_ps(); 
+            __m256 x = x0;
+            __m256 y = y0;
+
+            for (size_t i = 0; i < ITERS_CNT; ++i) {
+                __m256 yy = _mm256_mul_ps(y, y);
+                __m256 xy = _mm256_mul_ps(x, y);
+                
+                __m256 cmp = _mm256_cmp_ps(_mm256_fmadd_ps(x, x, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ); 
+
+                if (_mm256_testz_ps(cmp, cmp)) 
+                    break;
+                
+                iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE)); 
+                x = _mm256_add_ps(_mm256_fmsub_ps(x, x, yy), x0);
+                y = _mm256_fmadd_ps(xy, TWO, y0);
+            }
+
+            _mm256_storeu_si256((__m256i*)(iters_row + x_screen), _mm256_cvtps_epi32(iter));
+        }
+    }
+}
+#undef SIMD_OBJS_CNT
+
+// also writes |z|^2 of the first step outside the circle to state->escape_zz
+#define SIMD_OBJS_CNT 8 
+static void compute_frame_avx2_smooth_(uint32_t* const iters, const size_t iters_pitch,
+                                       const mandelbrat2_state_t* const state,
+                                       const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
+
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
+    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 INF                = _mm256_set1_ps(INFINITY);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        __m256 y0 = _mm256_set1_ps(((float)y_screen - state->y_offset) * SCALE);
+
+        uint32_t* const iters_row       = iters            + y_screen * ITERS_PITCH;
+        float*    const escape_zz_row   = state->escape_zz + y_screen * ITERS_PITCH;
+
+        for (size_t x_screen = rect->x; x_screen + SIMD_OBJS_CNT <= X_END; x_screen += SIMD_OBJS_CNT)
+        {
+            __m256 x0 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*0));
+                   x0 = _mm256_sub_ps(_mm256_mul_ps(x0, SCALE_VEC), X_OFFSET); 
+            
+            volatile __m256 iter = _mm256_setzero_ps(); 
+            __m256 x = x0;
+            __m256 y = y0;
+            __m256 escape_zz = INF;
+
+            for (size_t i = 0; i < ITERS_CNT; ++i) {
+                __m256 xx = _mm256_mul_ps(x, x);
+                __m256 yy = _mm256_mul_ps(y, y);
+                __m256 xy = _mm256_mul_ps(x, y);
+                
+                __m256 zz  = _mm256_add_ps(xx, yy);
+                __m256 cmp = _mm256_cmp_ps(zz, R_CIRCLE_INF2_VEC, _CMP_LE_OQ); 
+
+                // inside lanes turn into NaN, minps keeps its second operand over a NaN,
+                // and |z| only grows once outside
+                escape_zz = _mm256_min_ps(_mm256_or_ps(zz, cmp), escape_zz);
+
+                if (_mm256_testz_ps(cmp, cmp)) 
+                    break;
+                
+                iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE)); 
+                x = _mm256_add_ps(_mm256_sub_ps(xx, yy), x0);
+                y = _mm256_fmadd_ps(xy, TWO, y0);
+            }
+
+            _mm256_storeu_si256((__m256i*)(iters_row + x_screen), _mm256_cvtps_epi32(iter));
+            _mm256_storeu_ps(escape_zz_row + x_screen, escape_zz);
+        }
+    }
+}
+#undef SIMD_OBJS_CNT
+
+#define UNROLL_CNT 4
+#define SIMD_OBJS_CNT 8 
+static void compute_frame_omp_simd_unroll4_(uint32_t* const iters, const size_t iters_pitch,
+                                            const mandelbrat2_state_t* const state,
+                                            const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
+
+    float R_CIRCLE_INF2_VEC[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { R_CIRCLE_INF2_VEC[i] = state->r_circle_inf * state->r_circle_inf; }
+    
+    float SCALE_VEC[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { SCALE_VEC[i] = SCALE; }
+    
+    float X_OFFSET[SIMD_OBJS_CNT]  __aligned = {}; 
+#pragma omp simd 
+    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { X_OFFSET[i] = state->x_offset * SCALE; }
+    
+
+    float NATURAL08[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { NATURAL08[i] = (float)i; }
+
+// #ifdef COMPILE_OPTIMIZED
+// #pragma omp parallel for collapse(1) schedule(guided)
+// #endif /*COMPILE_OPTIMIZED*/
+
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        float y01[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+        for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y01[i] = ((float)y_screen - state->y_offset) * SCALE; }
+
+        float y02[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+        for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y02[i] = y01[i]; }
+        float y03[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+        for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y03[i] = y01[i]; }
+        float y04[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+        for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y04[i] = y01[i]; }
+
+
+        for (size_t x_screen = rect->x; x_screen + SIMD_OBJS_CNT*UNROLL_CNT <= X_END; 
+                    x_screen += SIMD_OBJS_CNT*UNROLL_CNT)
+        {
+            float x01[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] = (float)x_screen + 8*(1 - 1); }
+            float x02[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] = (float)x_screen + 8*(2 - 1); }
+            float x03[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] = (float)x_screen + 8*(3 - 1); }
+            float x04[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd 
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] = (float)x_screen + 8*(4 - 1); }
+            
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] += NATURAL08[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] += NATURAL08[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] += NATURAL08[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] += NATURAL08[i]; }
+
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] *= SCALE_VEC[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] *= SCALE_VEC[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] *= SCALE_VEC[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] *= SCALE_VEC[i]; }
+
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] -= X_OFFSET[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] -= X_OFFSET[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] -= X_OFFSET[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] -= X_OFFSET[i]; }    
+
+            volatile float iter1[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};
+            volatile float iter2[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};
+            volatile float iter3[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};
+            volatile float iter4[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};  
+
+
+            float x1[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x1[i] = x01[i]; } 
+            float x2[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x2[i] = x02[i]; } 
+            float x3[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x3[i] = x03[i]; } 
+            float x4[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x4[i] = x04[i]; } 
+
+
+            float y1[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y1[i] = y01[i]; } 
+            float y2[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y2[i] = y02[i]; } 
+            float y3[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y3[i] = y03[i]; } 
+            float y4[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y4[i] = y04[i]; } 
+
+
+            for (size_t iter_cnt = 0; iter_cnt < ITERS_CNT; ++iter_cnt)
+            {
+                float xx1[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx1[i] = x1[i] * x1[i]; } 
+                float xx2[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx2[i] = x2[i] * x2[i]; } 
+                float xx3[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx3[i] = x3[i] * x3[i]; } 
+                float xx4[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx4[i] = x4[i] * x4[i]; } 
+                
+
+                float yy1[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy1[i] = y1[i] * y1[i]; }
+                float yy2[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy2[i] = y2[i] * y2[i]; }
+                float yy3[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy3[i] = y3[i] * y3[i]; }
+                float yy4[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy4[i] = y4[i] * y4[i]; }
+
+
+                float xy1[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy1[i] = x1[i] * y1[i]; }
+                float xy2[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy2[i] = x2[i] * y2[i]; }
+                float xy3[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy3[i] = x3[i] * y3[i]; }
+                float xy4[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy4[i] = x4[i] * y4[i]; }
+
+
+                float sum21[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum21[i] = xx1[i] + yy1[i]; }
+                float sum22[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum22[i] = xx2[i] + yy2[i]; }
+                float sum23[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum23[i] = xx3[i] + yy3[i]; }
+                float sum24[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum24[i] = xx4[i] + yy4[i]; }
+                
+
+                float cmp1[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp1[i] = (sum21[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
+                float cmp2[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp2[i] = (sum22[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
+                float cmp3[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp3[i] = (sum23[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
+                float cmp4[SIMD_OBJS_CNT] __aligned = {}; 
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp4[i] = (sum24[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+                uint32_t cmp_acc1 = 0; 
+#pragma omp simd reduction(|:cmp_acc1)
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc1 |= *(uint32_t*)&cmp1[i]; }
+                int cmp_rez1 = (cmp_acc1 == 0); 
+                uint32_t cmp_acc2 = 0;
+#pragma omp simd reduction(|:cmp_acc2)
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc2 |= *(uint32_t*)&cmp2[i]; }
+                int cmp_rez2 = (cmp_acc2 == 0); 
+                uint32_t cmp_acc3 = 0; 
+#pragma omp simd reduction(|:cmp_acc3)
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc3 |= *(uint32_t*)&cmp3[i]; }
+                int cmp_rez3 = (cmp_acc3 == 0);
+                uint32_t cmp_acc4 = 0; 
+#pragma omp simd reduction(|:cmp_acc4)
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc4 |= *(uint32_t*)&cmp4[i]; }
+                int cmp_rez4 = (cmp_acc4 == 0);
+#pragma GCC diagnostic pop
+
+                if (cmp_rez1 && cmp_rez2 && cmp_rez3 && cmp_rez4) 
+                    break;
+                
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter1[i] += (cmp1[i] != 0.0f) ? 1.0f : 0.0f; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter2[i] += (cmp2[i] != 0.0f) ? 1.0f : 0.0f; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter3[i] += (cmp3[i] != 0.0f) ? 1.0f : 0.0f; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter4[i] += (cmp4[i] != 0.0f) ? 1.0f : 0.0f; }
+
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x1[i] = (xx1[i] - yy1[i]) + x01[i]; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x2[i] = (xx2[i] - yy2[i]) + x02[i]; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x3[i] = (xx3[i] - yy3[i]) + x03[i]; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x4[i] = (xx4[i] - yy4[i]) + x04[i]; }
+
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y1[i] = xy1[i] * 2.0f + y01[i]; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y2[i] = xy2[i] * 2.0f + y02[i]; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y3[i] = xy3[i] * 2.0f + y03[i]; }
+#pragma omp simd
+                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y4[i] = xy4[i] * 2.0f + y04[i]; }
+
+            }
+
+            uint32_t* const iters_row = iters + y_screen * ITERS_PITCH + x_screen;
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iters_row[i + SIMD_OBJS_CNT*(1-1)] = (uint32_t)iter1[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iters_row[i + SIMD_OBJS_CNT*(2-1)] = (uint32_t)iter2[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iters_row[i + SIMD_OBJS_CNT*(3-1)] = (uint32_t)iter3[i]; }
+#pragma omp simd
+            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iters_row[i + SIMD_OBJS_CNT*(4-1)] = (uint32_t)iter4[i]; }
+        }
+    }
+}
+#undef UNROLL_CNT
+#undef SIMD_OBJS_CNT
+
+// 2D blocks: one __m256 holds a 4x2 pixel block, lanes 0-3 are the upper row, lanes 4-7 the lower
+// one. Neighbours in both directions escape at close iterations, so less lanes idle near the border.
+#define STORE_BLOCK4X2_(x_block, y_block, iter_block)                                              \
+    do {                                                                                            \
+        const __m256i iter_int = _mm256_cvtps_epi32(iter_block);                                    \
+        _mm_storeu_si128((__m128i*)(iters + ((y_block) + 0) * ITERS_PITCH + (x_block)),             \
+                         _mm256_castsi256_si128(iter_int));                                         \
+        _mm_storeu_si128((__m128i*)(iters + ((y_block) + 1) * ITERS_PITCH + (x_block)),             \
+                         _mm256_extracti128_si256(iter_int, 1));                                    \
+    } while (0)
+
+#define BLOCK_WIDTH 4
+#define BLOCK_HEIGHT 2
+static void compute_frame_avx2_block4x2_(uint32_t* const iters, const size_t iters_pitch,
+                                         const mandelbrat2_state_t* const state,
+                                         const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
+
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
+    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
+    const __m256 Y_OFFSET           = _mm256_set1_ps(state->y_offset);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+    const __m256 BLOCK_X            = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 0.0f, 1.0f, 2.0f, 3.0f);
+    const __m256 BLOCK_Y            = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+
+    for (size_t y_screen = rect->y; y_screen + BLOCK_HEIGHT <= Y_END; y_screen += BLOCK_HEIGHT)
+    {
+        __m256 y0 = _mm256_add_ps(BLOCK_Y, _mm256_set1_ps((float)y_screen));
+               y0 = _mm256_mul_ps(_mm256_sub_ps(y0, Y_OFFSET), SCALE_VEC);
+
+        for (size_t x_screen = rect->x; x_screen + BLOCK_WIDTH <= X_END; x_screen += BLOCK_WIDTH)
+        {
+            __m256 x0 = _mm256_add_ps(BLOCK_X, _mm256_set1_ps((float)x_screen));
+                   x0 = _mm256_sub_ps(_mm256_mul_ps(x0, SCALE_VEC), X_OFFSET); 
+            
+            volatile __m256 iter = _mm256_setzero_ps(); 
+            __m256 x = x0;
+            __m256 y = y0;
+
+            for (size_t i = 0; i < ITERS_CNT; ++i) {
+                __m256 xx = _mm256_mul_ps(x, x);
+                __m256 yy = _mm256_mul_ps(y, y);
+                __m256 xy = _mm256_mul_ps(x, y);
+                
+                __m256 cmp = _mm256_cmp_ps(_mm256_add_ps(xx, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ); 
 
-    state->iters_cnt = START_ITERS_CNT;
-    state->r_circle_inf = START_R_CIRCLE_INF;
-    state->scale = START_SCALE;
+                if (_mm256_testz_ps(cmp, cmp)) 
+                    break;
+                
+                iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE)); 
+                x = _mm256_add_ps(_mm256_sub_ps(xx, yy), x0);
+                y = _mm256_fmadd_ps(xy, TWO, y0);
+            }
 
-    return MANDELBRAT2_ERROR_SUCCESS;
+            STORE_BLOCK4X2_(x_screen, y_screen, iter);
+        }
+    }
 }
+#undef BLOCK_WIDTH
+#undef BLOCK_HEIGHT
 
-#ifndef __AVX2__
-
-enum Mandelbrat2Error print_frame(SDL_Texture* pixels_texture, 
-                                  const mandelbrat2_state_t* const state,
-                                  const flags_objs_t* const flags_objs)
-{
-    if (flags_objs->use_graphics)
-    {
-        lassert(!is_invalid_ptr(pixels_texture), "");
-    }   
-    lassert(!is_invalid_ptr(state), "");
-    lassert(!is_invalid_ptr(flags_objs), "");
+// vectors 1 and 2 are the left and right halves of the upper 8x2 strip, 3 and 4 of the lower one
+#define Y0_CTOR_BLOCK8X4_                                                                           \
+    __m256 y01 = _mm256_add_ps(BLOCK_Y, _mm256_set1_ps((float)y_screen + 2*0));                     \
+    __m256 y03 = _mm256_add_ps(BLOCK_Y, _mm256_set1_ps((float)y_screen + 2*1));                     \
+           y01 = _mm256_mul_ps(_mm256_sub_ps(y01, Y_OFFSET), SCALE_VEC);                            \
+           y03 = _mm256_mul_ps(_mm256_sub_ps(y03, Y_OFFSET), SCALE_VEC);                            \
+    __m256 y02 = y01;                                                                               \
+    __m256 y04 = y03;
 
-    const double    R_CIRCLE_INF2   = state->r_circle_inf*state->r_circle_inf;
-    const double    SCALE           = 1 / state->scale;
-    const size_t    ITERS_CNT       = state->iters_cnt;
+#define X0_CTOR_BLOCK8X4_                                                                           \
+    __m256 x01 = _mm256_add_ps(BLOCK_X, _mm256_set1_ps((float)x_screen + 4*0));                     \
+    __m256 x02 = _mm256_add_ps(BLOCK_X, _mm256_set1_ps((float)x_screen + 4*1));                     \
+           x01 = _mm256_sub_ps(_mm256_mul_ps(x01, SCALE_VEC), X_OFFSET);                            \
+           x02 = _mm256_sub_ps(_mm256_mul_ps(x02, SCALE_VEC), X_OFFSET);                            \
+    __m256 x03 = x01;                                                                               \
+    __m256 x04 = x02;
 
-    void *pixels_void = NULL;
-    int pitch = 0;
+#define STORE_BLOCK8X4_                                                                             \
+    STORE_BLOCK4X2_(x_screen + 4*0, y_screen + 2*0, iter1);                                         \
+    STORE_BLOCK4X2_(x_screen + 4*1, y_screen + 2*0, iter2);                                         \
+    STORE_BLOCK4X2_(x_screen + 4*0, y_screen + 2*1, iter3);                                         \
+    STORE_BLOCK4X2_(x_screen + 4*1, y_screen + 2*1, iter4);
 
-    if (flags_objs->use_graphics)
-    {
-        SDL_ERROR_HANDLE_(SDL_LockTexture(pixels_texture, NULL, &pixels_void, &pitch));
-    }
+#define BLOCK_WIDTH 8
+#define BLOCK_HEIGHT 4
+static void compute_frame_avx2_block8x4_(uint32_t* const iters, const size_t iters_pitch,
+                                         const mandelbrat2_state_t* const state,
+                                         const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
 
-    Uint32* pixels = (Uint32*)pixels_void;
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
+    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
+    const __m256 Y_OFFSET           = _mm256_set1_ps(state->y_offset);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+    const __m256 BLOCK_X            = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 0.0f, 1.0f, 2.0f, 3.0f);
+    const __m256 BLOCK_Y            = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f);
 
-    
-    for (size_t repeat = 0; repeat < flags_objs->rep_calc_frame_cnt; ++repeat)
+    for (size_t y_screen = rect->y; y_screen + BLOCK_HEIGHT <= Y_END; y_screen += BLOCK_HEIGHT)
     {
+        Y0_CTOR_BLOCK8X4_
 
-// #ifdef COMPILE_OPTIMIZED
-// #pragma omp parallel for collapse(1) schedule(guided)
-// #endif /*COMPILE_OPTIMIZED*/
-
-        for (size_t y_screen = 0; y_screen < (size_t)flags_objs->screen_height; ++y_screen)
+        for (size_t x_screen = rect->x; x_screen + BLOCK_WIDTH <= X_END; x_screen += BLOCK_WIDTH)
         {
-            const double y0 = ((double)y_screen - state->y_offset) * SCALE;
-    
-            for (size_t x_screen = 0; x_screen < (size_t)flags_objs->screen_width; ++x_screen)
-            {
-                const double x0 = ((double)x_screen - state->x_offset) * SCALE;
-    
-                volatile size_t iter = 0;
-                for (double x = x0, y = y0; iter < ITERS_CNT; ++iter)
-                {
-                    const double xx = x * x;
-                    const double yy = y * y;
-                    const double xy = x * y;
-    
-                    if (xx + yy > R_CIRCLE_INF2) 
-                        break;
-                    
-                    x = xx - yy + x0;
-                    y = 2 * xy + y0;
-                }
-    
-                if (flags_objs->use_graphics)
-                {
-    
-                    const size_t pixel_addr = (y_screen) * (size_t)(pitch >> 2) + x_screen;
+            X0_CTOR_BLOCK8X4_
+            
+            ITER_CTOR4_
+            X_CTOR4_
+            Y_CTOR4_
+
+            for (size_t i = 0; i < ITERS_CNT; ++i) {
+                XX_CTOR4_
+                YY_CTOR4_
+                XY_CTOR4_
                 
-                    pixels[pixel_addr] = get_color(iter);
+                CMP_CTOR4_
+
+                if (CHECK_CMP4_) 
+                    break;
                 
-                }
+                UPDATE_ITER4_
+                UPDATE_X4_
+                UPDATE_Y4_
             }
+
+            STORE_BLOCK8X4_
         }
     }
+}
+#undef BLOCK_WIDTH
+#undef BLOCK_HEIGHT
 
-    if (flags_objs->use_graphics)
+// Unchecked steps that keep |z|^2 finite in float when a block starts from |z| <= R and |c| <= R
+static size_t deferred_safe_steps_(const float r_circle_inf)
+{
+    const double R = r_circle_inf;
+
+    double bound = R;
+    size_t steps = 0;
+    while (steps < ESCAPE_CHECK_PERIOD_MAX)
     {
-        SDL_UnlockTexture(pixels_texture);
+        const double next_bound = bound * bound + R;
+        if (!(2 * next_bound * next_bound < (double)FLT_MAX))
+            break;
+
+        bound = next_bound;
+        ++steps;
     }
 
-    return MANDELBRAT2_ERROR_SUCCESS;
+    return MAX(steps, 1lu);
 }
 
-#else /*__AVX2__*/
-
-#ifndef X86 //FIXME
+// Runs escape_check_period iterations between escape tests. When an active lane has escaped
+// inside the block, the block is replayed from its checkpoint with a test on every step, so
+// every lane gets its exact escape step. The step and the escape test are spelled with the same
+// explicit fmas as in the avx2 kernel, so the counts match it. Dead lanes are zeroed and stay at the 0 fixed point;
+// for periods longer than the overflow-safe step count, lanes that left the circle are retired
+// branch-free in the middle of the block.
+#define SIMD_OBJS_CNT 8 
+static void compute_frame_avx2_deferred_(uint32_t* const iters, const size_t iters_pitch,
+                                         const mandelbrat2_state_t* const state,
+                                         const mandelbrat2_rect_t* const rect)
+{
+    const float SCALE           = 1.0f / state->scale;
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t X_END          = rect->x + rect->width;
+    const size_t ITERS_PITCH    = iters_pitch;
+    const size_t ITERS_CNT      = state->iters_cnt;
+    const size_t CHECK_PERIOD   = state->escape_check_period;
+    const size_t SAFE_STEPS     = MIN(CHECK_PERIOD, deferred_safe_steps_(state->r_circle_inf));
 
-#ifndef UNROLL //FIXME
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
+    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
+    const __m256 ONE                = _mm256_set1_ps(1.0f);
+    const __m256 TWO                = _mm256_set1_ps(2.0f);
+    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
 
-#define Y0_CTOR4_                                                                                   \
-    __m256 y01 = _mm256_sub_ps(_mm256_set1_ps((float)y_screen * SCALE), Y_OFFSET);                  \
-    __m256 y02 = y01;                                                                               \
-    __m256 y03 = y01;                                                                               \
-    __m256 y04 = y01;
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        const __m256 y0 = _mm256_set1_ps(((float)y_screen - state->y_offset) * SCALE);
 
-#define X0_CTOR4_                                                                                   \
-    __m256 x01 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*0));                   \
-    __m256 x02 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*1));                   \
-    __m256 x03 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*2));                   \
-    __m256 x04 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*3));                   \
-           x01 = _mm256_sub_ps(_mm256_mul_ps(x01, SCALE_VEC), X_OFFSET);                            \
-           x02 = _mm256_sub_ps(_mm256_mul_ps(x02, SCALE_VEC), X_OFFSET);                            \
-           x03 = _mm256_sub_ps(_mm256_mul_ps(x03, SCALE_VEC), X_OFFSET);                            \
-           x04 = _mm256_sub_ps(_mm256_mul_ps(x04, SCALE_VEC), X_OFFSET);                            
+        uint32_t* const iters_row = iters + y_screen * ITERS_PITCH;
 
-#define ITER_CTOR4_                                                                                 \
-    volatile __m256 iter1 = _mm256_setzero_ps();                                                    \
-    volatile __m256 iter2 = _mm256_setzero_ps();                                                    \
-    volatile __m256 iter3 = _mm256_setzero_ps();                                                    \
-    volatile __m256 iter4 = _mm256_setzero_ps();                                                             
+        for (size_t x_screen = rect->x; x_screen + SIMD_OBJS_CNT <= X_END; x_screen += SIMD_OBJS_CNT)
+        {
+            __m256 x0 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*0));
+                   x0 = _mm256_fmsub_ps(x0, SCALE_VEC, X_OFFSET); 
 
-#define X_CTOR4_                                                                                    \
-    __m256 x1 = x01;                                                                                \
-    __m256 x2 = x02;                                                                                \
-    __m256 x3 = x03;                                                                                \
-    __m256 x4 = x04;                                                                                
+            __m256 active = _mm256_cmp_ps(_mm256_fmadd_ps(x0, x0, _mm256_mul_ps(y0, y0)), 
+                                          R_CIRCLE_INF2_VEC, _CMP_LE_OQ);
+            __m256 cx = _mm256_and_ps(x0, active);
+            __m256 cy = _mm256_and_ps(y0, active);
+            __m256 x  = cx;
+            __m256 y  = cy;
 
-#define Y_CTOR4_                                                                                    \
-    __m256 y1 = y01;                                                                                \
-    __m256 y2 = y02;                                                                                \
-    __m256 y3 = y03;                                                                                \
-    __m256 y4 = y04;                                                                                
+            volatile __m256 iter = _mm256_setzero_ps(); 
 
-#define XX_CTOR4_                                                                                   \
-    __m256 xx1 = _mm256_mul_ps(x1, x1);                                                             \
-    __m256 xx2 = _mm256_mul_ps(x2, x2);                                                             \
-    __m256 xx3 = _mm256_mul_ps(x3, x3);                                                             \
-    __m256 xx4 = _mm256_mul_ps(x4, x4);                                                             
+            for (size_t i = 0; i < ITERS_CNT && !_mm256_testz_ps(active, active); i += CHECK_PERIOD)
+            {
+                const size_t STEPS  = MIN(CHECK_PERIOD, ITERS_CNT - i);
+                const __m256 x_cp   = x;
+                const __m256 y_cp   = y;
+                __m256 escaped      = _mm256_setzero_ps();
 
-#define YY_CTOR4_                                                                                   \
-    __m256 yy1 = _mm256_mul_ps(y1, y1);                                                             \
-    __m256 yy2 = _mm256_mul_ps(y2, y2);                                                             \
-    __m256 yy3 = _mm256_mul_ps(y3, y3);                                                             \
-    __m256 yy4 = _mm256_mul_ps(y4, y4);                                                             
+                for (size_t done = 0; done < STEPS; done += SAFE_STEPS)
+                {
+                    if (done)
+                    {
+                        const __m256 out = _mm256_cmp_ps(_mm256_fmadd_ps(x, x, _mm256_mul_ps(y, y)), 
+                                                         R_CIRCLE_INF2_VEC, _CMP_NLE_UQ);
+                        escaped = _mm256_or_ps   (escaped, out);
+                        x       = _mm256_andnot_ps(out, x);
+                        y       = _mm256_andnot_ps(out, y);
+                        cx      = _mm256_andnot_ps(out, cx);
+                        cy      = _mm256_andnot_ps(out, cy);
+                    }
 
-#define XY_CTOR4_                                                                                   \
-    __m256 xy1 = _mm256_mul_ps(x1, y1);                                                             \
-    __m256 xy2 = _mm256_mul_ps(x2, y2);                                                             \
-    __m256 xy3 = _mm256_mul_ps(x3, y3);                                                             \
-    __m256 xy4 = _mm256_mul_ps(x4, y4);                                                             
+                    const size_t SUB_STEPS = MIN(SAFE_STEPS, STEPS - done);
+                    for (size_t step = 0; step < SUB_STEPS; ++step)
+                    {
+                        const __m256 yy = _mm256_mul_ps(y, y);
+                        const __m256 xy = _mm256_mul_ps(x, y);
+                        x = _mm256_add_ps(_mm256_fmsub_ps(x, x, yy), cx);
+                        y = _mm256_fmadd_ps(xy, TWO, cy);
+                    }
+                }
 
-#define CMP_CTOR4_                                                                                  \
-    __m256 cmp1 = _mm256_cmp_ps(_mm256_add_ps(xx1, yy1), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);            \
-    __m256 cmp2 = _mm256_cmp_ps(_mm256_add_ps(xx2, yy2), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);            \
-    __m256 cmp3 = _mm256_cmp_ps(_mm256_add_ps(xx3, yy3), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);            \
-    __m256 cmp4 = _mm256_cmp_ps(_mm256_add_ps(xx4, yy4), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);  
+                const __m256 inside = _mm256_andnot_ps(escaped, 
+                    _mm256_cmp_ps(_mm256_fmadd_ps(x, x, _mm256_mul_ps(y, y)), R_CIRCLE_INF2_VEC, _CMP_LE_OQ));
 
-#define CHECK_CMP4_                                                                                 \
-    (                                                                                               \
-        _mm256_testz_ps(cmp1, cmp1)                                                                 \
-     && _mm256_testz_ps(cmp2, cmp2)                                                                 \
-     && _mm256_testz_ps(cmp3, cmp3)                                                                 \
-     && _mm256_testz_ps(cmp4, cmp4)                                                                 \
-    )
+                if (_mm256_testc_ps(inside, active))
+                {
+                    iter = _mm256_add_ps(iter, _mm256_and_ps(active, _mm256_set1_ps((float)STEPS)));
+                    continue;
+                }
 
-#define UPDATE_ITER4_                                                                               \
-    iter1 = _mm256_add_ps(iter1, _mm256_and_ps(cmp1, ONE));                                         \
-    iter2 = _mm256_add_ps(iter2, _mm256_and_ps(cmp2, ONE));                                         \
-    iter3 = _mm256_add_ps(iter3, _mm256_and_ps(cmp3, ONE));                                         \
-    iter4 = _mm256_add_ps(iter4, _mm256_and_ps(cmp4, ONE));
+                x  = x_cp;
+                y  = y_cp;
+                cx = _mm256_and_ps(x0, active);
+                cy = _mm256_and_ps(y0, active);
+                for (size_t step = 0; step < STEPS; ++step)
+                {
+                    const __m256 yy = _mm256_mul_ps(y, y);
+                    const __m256 xy = _mm256_mul_ps(x, y);
 
-#define UPDATE_X4_                                                                                  \
-    x1 = _mm256_add_ps(_mm256_sub_ps(xx1, yy1), x01);                                               \
-    x2 = _mm256_add_ps(_mm256_sub_ps(xx2, yy2), x02);                                               \
-    x3 = _mm256_add_ps(_mm256_sub_ps(xx3, yy3), x03);                                               \
-    x4 = _mm256_add_ps(_mm256_sub_ps(xx4, yy4), x04);
+                    active  = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_fmadd_ps(x, x, yy), 
+                                                                  R_CIRCLE_INF2_VEC, _CMP_LE_OQ));
+                    iter    = _mm256_add_ps(iter, _mm256_and_ps(active, ONE));
+                    cx      = _mm256_and_ps(cx, active);
+                    cy      = _mm256_and_ps(cy, active);
+                    x       = _mm256_and_ps(_mm256_add_ps(_mm256_fmsub_ps(x, x, yy), cx), active);
+                    y       = _mm256_and_ps(_mm256_fmadd_ps(xy, TWO, cy), active);
+                }
 
-#define UPDATE_Y4_                                                                                  \
-    y1 = _mm256_fmadd_ps(xy1, TWO, y01);                                                            \
-    y2 = _mm256_fmadd_ps(xy2, TWO, y02);                                                            \
-    y3 = _mm256_fmadd_ps(xy3, TWO, y03);                                                            \
-    y4 = _mm256_fmadd_ps(xy4, TWO, y04);
+                // next checkpoint must start inside the circle
+                active  = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_fmadd_ps(x, x, _mm256_mul_ps(y, y)), 
+                                                              R_CIRCLE_INF2_VEC, _CMP_LE_OQ));
+                cx      = _mm256_and_ps(cx, active);
+                cy      = _mm256_and_ps(cy, active);
+                x       = _mm256_and_ps(x,  active);
+                y       = _mm256_and_ps(y,  active);
+            }
 
+            _mm256_storeu_si256((__m256i*)(iters_row + x_screen), _mm256_cvtps_epi32(iter));
+        }
+    }
+}
+#undef SIMD_OBJS_CNT
 
-#ifndef __aligned
-#define __aligned __attribute__((aligned(32)))
-#endif
+#define DISTANCE_NOT_DONE_      UINT32_MAX
+#define DISTANCE_FILL_SHARE_    0.25f   // tuned with -D, not derived
 
-#define UNROLL_CNT 4
-#define SIMD_OBJS_CNT 8 
-enum Mandelbrat2Error print_frame(SDL_Texture* pixels_texture, 
-                                  const mandelbrat2_state_t* const state,
-                                  const flags_objs_t* const flags_objs)
+static void fill_exterior_disk_(uint32_t* const iters, const size_t iters_pitch, 
+                                const mandelbrat2_rect_t* const rect, const size_t x_center, 
+                                const size_t y_center, const size_t radius, const uint32_t iter)
 {
-    if (flags_objs->use_graphics)
+    const size_t Y_END = MIN(rect->y + rect->height, y_center + radius + 1);
+
+    for (size_t y_screen = y_center; y_screen < Y_END; ++y_screen)
     {
-        lassert(!is_invalid_ptr(pixels_texture), "");
-    }   
-    lassert(!is_invalid_ptr(state), "");
-    lassert(!is_invalid_ptr(flags_objs), "");
+        const size_t dy         = y_screen - y_center;
+        const size_t half_width = (size_t)sqrt((double)(radius * radius - dy * dy));
+        const size_t x_begin    = x_center >= rect->x + half_width ? x_center - half_width : rect->x;
+        const size_t x_end      = MIN(rect->x + rect->width, x_center + half_width + 1);
+
+        uint32_t* const iters_row = iters + y_screen * iters_pitch;
+        for (size_t x_screen = x_begin; x_screen < x_end; ++x_screen)
+        {
+            if (iters_row[x_screen] == DISTANCE_NOT_DONE_)
+                iters_row[x_screen] = iter;
+        }
+    }
+}
 
+// Batches with escaped lanes replay their orbit with dz = dz_n/dc, so the interior doesn't pay for it.
+// By the Koebe quarter theorem |z| ln|z| / (2 |dz|) bounds the distance to the set from below as |z|
+// grows; with the small bailout radius it is only an estimate. The smooth count changes by about ln 2
+// per |z| ln|z| / |dz| of c, so a disk of DISTANCE_FILL_SHARE_ of the bound keeps most filled counts
+// within one of the sample, which -D measures against the avx2 kernel. Only integer counts are
+// produced, smooth colouring always runs its own kernel. Iterated pixels match the avx2 kernel exactly.
+#define SIMD_OBJS_CNT 8 
+static void distance_batch_(uint32_t* const iters, const size_t iters_pitch, 
+                            const mandelbrat2_state_t* const state, const mandelbrat2_rect_t* const rect,
+                            const uint32_t* const lanes_x, const size_t y_screen)
+{
     const float SCALE           = 1.0f / state->scale;
-    const size_t REP_CNT        = flags_objs->rep_calc_frame_cnt;
-    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
-    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width - (SIMD_OBJS_CNT*UNROLL_CNT - 1);
     const size_t ITERS_CNT      = state->iters_cnt;
+    const float R_CIRCLE_INF2   = state->r_circle_inf * state->r_circle_inf;
+    const float RADIUS_SCALE    = 0.25f * state->scale * DISTANCE_FILL_SHARE_;
+    const float RADIUS_MAX      = (float)(rect->width + rect->height);
 
-    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(R_CIRCLE_INF2);
     const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
     const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
-    const __m256 Y_OFFSET           = _mm256_set1_ps(state->y_offset * SCALE);
     const __m256 ONE                = _mm256_set1_ps(1.0f);
     const __m256 TWO                = _mm256_set1_ps(2.0f);
-    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 ITERS_CNT_VEC      = _mm256_set1_ps((float)ITERS_CNT);
 
-    void *pixels_void __aligned = NULL;
-    int pitch = 0;
+    const __m256 y0 = _mm256_set1_ps(((float)y_screen - state->y_offset) * SCALE);
+    const __m256 x0 = _mm256_fmsub_ps(_mm256_cvtepi32_ps(_mm256_load_si256((const __m256i*)lanes_x)), 
+                                      SCALE_VEC, X_OFFSET);
 
-    if (flags_objs->use_graphics)
+    volatile __m256 iter = _mm256_setzero_ps(); 
+    __m256 x = x0;
+    __m256 y = y0;
+
+    for (size_t i = 0; i < ITERS_CNT; ++i) {
+        __m256 yy = _mm256_mul_ps(y, y);
+        __m256 xy = _mm256_mul_ps(x, y);
+        
+        __m256 cmp = _mm256_cmp_ps(_mm256_fmadd_ps(x, x, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ); 
+
+        if (_mm256_testz_ps(cmp, cmp)) 
+            break;
+        
+        iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE)); 
+        x = _mm256_add_ps(_mm256_fmsub_ps(x, x, yy), x0);
+        y = _mm256_fmadd_ps(xy, TWO, y0);
+    }
+
+    const __m256 counts = iter;
+    uint32_t __aligned lanes_iter[SIMD_OBJS_CNT];
+    _mm256_store_si256((__m256i*)lanes_iter, _mm256_cvtps_epi32(counts));
+
+    uint32_t* const iters_row = iters + y_screen * iters_pitch;
+    for (size_t lane = 0; lane < SIMD_OBJS_CNT; ++lane)
     {
-        SDL_ERROR_HANDLE_(SDL_LockTexture(pixels_texture, NULL, &pixels_void, &pitch));
+        iters_row[lanes_x[lane]] = lanes_iter[lane];
     }
 
-    Uint32* pixels __aligned = (Uint32*)pixels_void;
+    __m256 active = _mm256_cmp_ps(counts, ITERS_CNT_VEC, _CMP_LT_OQ);
+    if (_mm256_testz_ps(active, active))
+        return;
 
-    
-    for (size_t repeat = 0; repeat < REP_CNT; ++repeat)
+    // z and dz of a lane freeze after its count of steps
+    x = x0;
+    y = y0;
+    __m256 dx = ONE;
+    __m256 dy = _mm256_setzero_ps();
+
+    for (size_t i = 0; i < ITERS_CNT; ++i) {
+        active = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_set1_ps((float)i), counts, _CMP_LT_OQ));
+
+        if (_mm256_testz_ps(active, active)) 
+            break;
+
+        __m256 yy = _mm256_mul_ps(y, y);
+        __m256 xy = _mm256_mul_ps(x, y);
+
+        __m256 new_dx = _mm256_fmadd_ps(_mm256_fmsub_ps(x, dx, _mm256_mul_ps(y, dy)), TWO, ONE);
+        __m256 new_dy = _mm256_mul_ps(_mm256_fmadd_ps(x, dy, _mm256_mul_ps(y, dx)), TWO);
+
+        x  = _mm256_blendv_ps(x,  _mm256_add_ps(_mm256_fmsub_ps(x, x, yy), x0), active);
+        y  = _mm256_blendv_ps(y,  _mm256_fmadd_ps(xy, TWO, y0), active);
+        dx = _mm256_blendv_ps(dx, new_dx, active);
+        dy = _mm256_blendv_ps(dy, new_dy, active);
+    }
+
+    // |z| ln|z| / (2 |dz|) = sqrt(|z|^2 / |dz|^2) ln(|z|^2) / 4
+    float __aligned lanes_zz  [SIMD_OBJS_CNT];
+    float __aligned lanes_dzdz[SIMD_OBJS_CNT];
+    _mm256_store_ps(lanes_zz,   _mm256_fmadd_ps(x,  x,  _mm256_mul_ps(y,  y)));
+    _mm256_store_ps(lanes_dzdz, _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy)));
+
+    for (size_t lane = 0; lane < SIMD_OBJS_CNT; ++lane)
     {
+        if (!(lanes_zz[lane] > R_CIRCLE_INF2))
+            continue;
 
-// #ifdef COMPILE_OPTIMIZED
-// #pragma omp parallel for collapse(1) schedule(guided)
-// #endif /*COMPILE_OPTIMIZED*/
+        const float radius = sqrtf(lanes_zz[lane] / lanes_dzdz[lane]) * logf(lanes_zz[lane]) * RADIUS_SCALE;
+        if (!(radius >= 1))
+            continue;
 
-        for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
+        fill_exterior_disk_(iters, iters_pitch, rect, lanes_x[lane], y_screen, 
+                            (size_t)MIN(radius, RADIUS_MAX), lanes_iter[lane]);
+    }
+}
+
+// The rect is scanned row by row and pixels that no disk has filled yet are gathered into batches,
+// the disks fill the rest of the row and the rows below.
+static void compute_frame_avx2_distance_(uint32_t* const iters, const size_t iters_pitch,
+                                         const mandelbrat2_state_t* const state,
+                                         const mandelbrat2_rect_t* const rect)
+{
+    const size_t Y_END          = rect->y + rect->height;
+    const size_t ITERS_PITCH    = iters_pitch;
+
+    // a tail shorter than a batch is left to the scalar pass, like in the other kernels
+    const mandelbrat2_rect_t BATCHES_RECT = {rect->x, rect->y, rect->width / SIMD_OBJS_CNT * SIMD_OBJS_CNT, 
+                                             rect->height};
+    const size_t X_END          = BATCHES_RECT.x + BATCHES_RECT.width;
+
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        for (size_t x_screen = BATCHES_RECT.x; x_screen < X_END; ++x_screen)
         {
-            Y0_CTOR4_
-    
-            for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; x_screen += SIMD_OBJS_CNT*UNROLL_CNT)
+            iters[y_screen * ITERS_PITCH + x_screen] = DISTANCE_NOT_DONE_;
+        }
+    }
+
+    uint32_t __aligned lanes_x[SIMD_OBJS_CNT];
+
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)
+    {
+        const uint32_t* const iters_row = iters + y_screen * ITERS_PITCH;
+        size_t lanes_cnt = 0;
+
+        for (size_t x_screen = rect->x; x_screen < X_END; ++x_screen)
+        {
+            if (iters_row[x_screen] != DISTANCE_NOT_DONE_)
+                continue;
+
+            lanes_x[lanes_cnt++] = (uint32_t)x_screen;
+            if (lanes_cnt == SIMD_OBJS_CNT)
             {
-                X0_CTOR4_
-                
-                ITER_CTOR4_
-                X_CTOR4_
-                Y_CTOR4_
-
-                for (size_t i = 0; i < ITERS_CNT; ++i) {
-                    XX_CTOR4_
-                    YY_CTOR4_
-                    XY_CTOR4_
-                    
-                    CMP_CTOR4_
-
-                    if (CHECK_CMP4_) 
-                        break;
-                    
-                    UPDATE_ITER4_
-                    UPDATE_X4_
-                    UPDATE_Y4_
-                }
+                distance_batch_(iters, ITERS_PITCH, state, &BATCHES_RECT, lanes_x, y_screen);
+                lanes_cnt = 0;
+            }
+        }
 
-                if (flags_objs->use_graphics)
-                {
-                    float iter[UNROLL_CNT*SIMD_OBJS_CNT] = {};
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(1-1)] = iter1[i] ;}
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(2-1)] = iter2[i] ;}
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(3-1)] = iter3[i] ;}
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(4-1)] = iter4[i] ;}
+        if (lanes_cnt)
+        {
+            for (size_t lane = lanes_cnt; lane < SIMD_OBJS_CNT; ++lane)
+            {
+                lanes_x[lane] = lanes_x[lanes_cnt - 1];
+            }
+            distance_batch_(iters, ITERS_PITCH, state, &BATCHES_RECT, lanes_x, y_screen);
+        }
+    }
+}
+#undef SIMD_OBJS_CNT
+#undef DISTANCE_NOT_DONE_
+#undef DISTANCE_FILL_SHARE_
+
+// the same steps on 8 float lanes, the constants are hoisted out of the loop by the compiler
+#define FORMULA_STEP_PS_mandelbrot_(x, y, xx, yy, c_x, c_y)                                         \
+    do {                                                                                            \
+        y = _mm256_fmadd_ps(_mm256_mul_ps(x, y), _mm256_set1_ps(2.0f), c_y);                        \
+        x = _mm256_add_ps(_mm256_sub_ps(xx, yy), c_x);                                              \
+    } while(0)
+
+#define FORMULA_STEP_PS_multibrot3_(x, y, xx, yy, c_x, c_y)                                         \
+    do {                                                                                            \
+        const __m256 x_ = _mm256_fmadd_ps(x, _mm256_fnmadd_ps(_mm256_set1_ps(3.0f), yy, xx), c_x);  \
+        y = _mm256_fmadd_ps(y, _mm256_fmsub_ps(_mm256_set1_ps(3.0f), xx, yy), c_y);                 \
+        x = x_;                                                                                     \
+    } while(0)
+
+#define FORMULA_STEP_PS_multibrot4_(x, y, xx, yy, c_x, c_y)                                         \
+    do {                                                                                            \
+        const __m256 re_ = _mm256_sub_ps(xx, yy);                                                   \
+        const __m256 im_ = _mm256_mul_ps(_mm256_mul_ps(x, y), _mm256_set1_ps(2.0f));                \
+        x = _mm256_add_ps(_mm256_fmsub_ps(re_, re_, _mm256_mul_ps(im_, im_)), c_x);                 \
+        y = _mm256_fmadd_ps(_mm256_mul_ps(re_, im_), _mm256_set1_ps(2.0f), c_y);                    \
+    } while(0)
+
+#define FORMULA_STEP_PS_burning_ship_(x, y, xx, yy, c_x, c_y)                                       \
+    do {                                                                                            \
+        const __m256 xy_ = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_mul_ps(x, y));            \
+        y = _mm256_fmadd_ps(xy_, _mm256_set1_ps(2.0f), c_y);                                        \
+        x = _mm256_add_ps(_mm256_sub_ps(xx, yy), c_x);                                              \
+    } while(0)
+
+#define FORMULA_STEP_PS_tricorn_(x, y, xx, yy, c_x, c_y)                                            \
+    do {                                                                                            \
+        y = _mm256_fnmadd_ps(_mm256_mul_ps(x, y), _mm256_set1_ps(2.0f), c_y);                       \
+        x = _mm256_add_ps(_mm256_sub_ps(xx, yy), c_x);                                              \
+    } while(0)
+
+// compute_frame_avx2_ with the step pasted in. x0 is (x - x_offset) * scale like y0,
+// so both negate exactly about the axes and the mirrored halves match a full compute
+#define SIMD_OBJS_CNT 8 
+#define FORMULA_KERNEL_AVX2_(kernel, step, prologue, c_x, c_y)                                      \
+static void kernel(uint32_t* const iters, const size_t iters_pitch,                                 \
+                   const mandelbrat2_state_t* const state,                                          \
+                   const mandelbrat2_rect_t* const rect)                                            \
+{                                                                                                   \
+    const float SCALE           = 1.0f / state->scale;                                              \
+    const size_t Y_END          = rect->y + rect->height;                                           \
+    const size_t X_END          = rect->x + rect->width;                                            \
+    const size_t ITERS_PITCH    = iters_pitch;                                                      \
+    const size_t ITERS_CNT      = state->iters_cnt;                                                 \
+                                                                                                    \
+    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);    \
+    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);                                        \
+    const __m256 ONE                = _mm256_set1_ps(1.0f);                                         \
+    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);\
+    prologue                                                                                        \
+                                                                                                    \
+    for (size_t y_screen = rect->y; y_screen < Y_END; ++y_screen)                                   \
+    {                                                                                               \
+        __m256 y0 = _mm256_set1_ps(((float)y_screen - state->y_offset) * SCALE);                    \
+                                                                                                    \
+        uint32_t* const iters_row = iters + y_screen * ITERS_PITCH;                                 \
+                                                                                                    \
+        for (size_t x_screen = rect->x; x_screen + SIMD_OBJS_CNT <= X_END; x_screen += SIMD_OBJS_CNT)\
+        {                                                                                           \
+            __m256 x0 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen - state->x_offset));\
+                   x0 = _mm256_mul_ps(x0, SCALE_VEC);                                               \
+                                                                                                    \
+            volatile __m256 iter = _mm256_setzero_ps();                                             \
+            __m256 x = x0;                                                                          \
+            __m256 y = y0;                                                                          \
+                                                                                                    \
+            for (size_t i = 0; i < ITERS_CNT; ++i) {                                                \
+                __m256 xx = _mm256_mul_ps(x, x);                                                    \
+                __m256 yy = _mm256_mul_ps(y, y);                                                    \
+                                                                                                    \
+                __m256 cmp = _mm256_cmp_ps(_mm256_add_ps(xx, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ);   \
+                                                                                                    \
+                if (_mm256_testz_ps(cmp, cmp))                                                      \
+                    break;                                                                          \
+                                                                                                    \
+                iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE));                                \
+                step(x, y, xx, yy, c_x, c_y);                                                       \
+            }                                                                                       \
+                                                                                                    \
+            _mm256_storeu_si256((__m256i*)(iters_row + x_screen), _mm256_cvtps_epi32(iter));        \
+        }                                                                                           \
+    }                                                                                               \
+}
 
-                    for (size_t i = 0; i < SIMD_OBJS_CNT*UNROLL_CNT; ++i)
-                    {
-                        const size_t pixel_addr = (y_screen) * (size_t)(pitch >> 2) + x_screen + i;
-                
-                        pixels[pixel_addr] = get_color(iter[i]);
+#define FORMULA_JULIA_PROLOGUE_AVX2_                                                                \
+    const __m256 JULIA_X = _mm256_set1_ps(state->julia_x);                                          \
+    const __m256 JULIA_Y = _mm256_set1_ps(state->julia_y);
 
-                    }         
-                }
-            }
-        }
-    }
+#define FORMULA_KERNELS_AVX2_(name, is_symmetric, is_even)                                          \
+    FORMULA_KERNEL_AVX2_(compute_frame_avx2_##name##_, FORMULA_STEP_PS_##name##_, , x0, y0)         \
+    FORMULA_KERNEL_AVX2_(compute_frame_avx2_julia_##name##_, FORMULA_STEP_PS_##name##_,             \
+                         FORMULA_JULIA_PROLOGUE_AVX2_, JULIA_X, JULIA_Y)
 
-    if (flags_objs->use_graphics)
-    {
-        SDL_UnlockTexture(pixels_texture);
-    }
+FORMULA_LIST_(FORMULA_KERNELS_AVX2_)
+FORMULA_KERNEL_AVX2_(compute_frame_avx2_julia_mandelbrot_, FORMULA_STEP_PS_mandelbrot_, 
+                     FORMULA_JULIA_PROLOGUE_AVX2_, JULIA_X, JULIA_Y)
+#undef FORMULA_KERNELS_AVX2_
+#undef FORMULA_JULIA_PROLOGUE_AVX2_
+#undef FORMULA_KERNEL_AVX2_
+#undef SIMD_OBJS_CNT
+#undef FORMULA_STEP_PS_mandelbrot_
+#undef FORMULA_STEP_PS_multibrot3_
+#undef FORMULA_STEP_PS_multibrot4_
+#undef FORMULA_STEP_PS_burning_ship_
+#undef FORMULA_STEP_PS_tricorn_
 
-    return MANDELBRAT2_ERROR_SUCCESS;
-}
+#endif /*__AVX2__*/
 
-#else /*UNROLL*/
+static const mandelbrat2_kernel_info_t KERNELS_[] = {
+    {"scalar",                  compute_frame_scalar_,                  compute_frame_scalar_,          1,  1, true,  false},
+    {"scalar_smooth",           compute_frame_scalar_smooth_,           compute_frame_scalar_smooth_,   1,  1, true,  true },
+#define FORMULA_KERNEL_INFO_SCALAR_(name, is_symmetric, is_even)                                                \
+    {"scalar_" #name,           compute_frame_scalar_##name##_,         compute_frame_scalar_##name##_,         \
+                                1,  1, false, false},                                                           \
+    {"scalar_julia_" #name,     compute_frame_scalar_julia_##name##_,   compute_frame_scalar_julia_##name##_,   \
+                                1,  1, false, false},
+    {"scalar_julia_mandelbrot", compute_frame_scalar_julia_mandelbrot_, compute_frame_scalar_julia_mandelbrot_,
+                                1,  1, false, false},
+    FORMULA_LIST_(FORMULA_KERNEL_INFO_SCALAR_)
+#undef FORMULA_KERNEL_INFO_SCALAR_
+#ifdef __AVX2__
+    {"avx2",                    compute_frame_avx2_,                    compute_frame_scalar_,          8,  1, true,  false},
+    {"avx2_unroll4",            compute_frame_avx2_unroll4_,            compute_frame_scalar_,          32, 1, true,  false},
+    {"omp_simd_unroll4",        compute_frame_omp_simd_unroll4_,        compute_frame_scalar_,          32, 1, true,  false},
+    {"avx2_block4x2",           compute_frame_avx2_block4x2_,           compute_frame_scalar_,          4,  2, true,  false},
+    {"avx2_block8x4",           compute_frame_avx2_block8x4_,           compute_frame_scalar_,          8,  4, true,  false},
+    {"avx2_deferred",           compute_frame_avx2_deferred_,           compute_frame_scalar_,          8,  1, true,  false},
+    {"avx2_distance",           compute_frame_avx2_distance_,           compute_frame_scalar_,          8,  1, true,  false},
+    {"avx2_smooth",             compute_frame_avx2_smooth_,             compute_frame_scalar_smooth_,   8,  1, true,  true },
+#define FORMULA_KERNEL_INFO_AVX2_(name, is_symmetric, is_even)                                                  \
+    {"avx2_" #name,             compute_frame_avx2_##name##_,           compute_frame_scalar_##name##_,         \
+                                8,  1, false, false},                                                           \
+    {"avx2_julia_" #name,       compute_frame_avx2_julia_##name##_,     compute_frame_scalar_julia_##name##_,   \
+                                8,  1, false, false},
+    {"avx2_julia_mandelbrot",   compute_frame_avx2_julia_mandelbrot_,   compute_frame_scalar_julia_mandelbrot_,
+                                8,  1, false, false},
+    FORMULA_LIST_(FORMULA_KERNEL_INFO_AVX2_)
+#undef FORMULA_KERNEL_INFO_AVX2_
+#endif /*__AVX2__*/
+};
 
-#ifndef __aligned
-#define __aligned __attribute__((aligned(32)))
+// kernel that the build flags used to select before the runtime table existed
+#ifndef __AVX2__
+#define DEFAULT_KERNEL_NAME_ "scalar"
+#elif defined(X86)
+#define DEFAULT_KERNEL_NAME_ "omp_simd_unroll4"
+#elif defined(UNROLL)
+#define DEFAULT_KERNEL_NAME_ "avx2"
+#else
+#define DEFAULT_KERNEL_NAME_ "avx2_unroll4"
 #endif
 
-#define SIMD_OBJS_CNT 8 
-enum Mandelbrat2Error print_frame(SDL_Texture* pixels_texture, 
-                                  const mandelbrat2_state_t* const state,
-                                  const flags_objs_t* const flags_objs)
+size_t mandelbrat2_kernels_cnt(void)
 {
-    if (flags_objs->use_graphics)
-    {
-        lassert(!is_invalid_ptr(pixels_texture), "");
-    }   
-    lassert(!is_invalid_ptr(state), "");
-    lassert(!is_invalid_ptr(flags_objs), "");
+    return sizeof(KERNELS_) / sizeof(*KERNELS_);
+}
 
-    const float SCALE           = 1.0f / state->scale;
-    const size_t REP_CNT        = flags_objs->rep_calc_frame_cnt;
-    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
-    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width - (SIMD_OBJS_CNT- 1);
-    const size_t ITERS_CNT      = state->iters_cnt;
+const mandelbrat2_kernel_info_t* mandelbrat2_kernel(const size_t kernel)
+{
+    lassert(kernel < mandelbrat2_kernels_cnt(), "");
 
-    const __m256 R_CIRCLE_INF2_VEC  = _mm256_set1_ps(state->r_circle_inf * state->r_circle_inf);
-    const __m256 SCALE_VEC          = _mm256_set1_ps(SCALE);
-    const __m256 X_OFFSET           = _mm256_set1_ps(state->x_offset * SCALE);
-    const __m256 Y_OFFSET           = _mm256_set1_ps(state->y_offset * SCALE);
-    const __m256 ONE                = _mm256_set1_ps(1.0f);
-    const __m256 TWO                = _mm256_set1_ps(2.0f);
-    const __m256 NATURAL08          = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    return &KERNELS_[kernel];
+}
 
-    void *pixels_void __aligned = NULL;
-    int pitch = 0;
+size_t mandelbrat2_kernel_find(const char* const name)
+{
+    lassert(!is_invalid_ptr(name), "");
 
-    if (flags_objs->use_graphics)
+    const char* const find_name = (*name == '\0') ? DEFAULT_KERNEL_NAME_ : name;
+
+    for (size_t kernel = 0; kernel < mandelbrat2_kernels_cnt(); ++kernel)
     {
-        SDL_ERROR_HANDLE_(SDL_LockTexture(pixels_texture, NULL, &pixels_void, &pitch));
+        if (strcmp(KERNELS_[kernel].name, find_name) == 0)
+            return kernel;
     }
 
-    Uint32* pixels __aligned = (Uint32*)pixels_void;
+    return mandelbrat2_kernels_cnt();
+}
+#undef DEFAULT_KERNEL_NAME_
 
-    
-    for (size_t repeat = 0; repeat < REP_CNT; ++repeat)
-    {
+// entries are in [0, START_ITERS_CNT), the interior keeps get_color(START_ITERS_CNT) in every palette
+static Uint32 palette_settings_(const size_t entry)
+{
+    return get_color(entry);
+}
 
-// #ifdef COMPILE_OPTIMIZED
-// #pragma omp parallel for collapse(1) schedule(guided)
-// #endif /*COMPILE_OPTIMIZED*/
+static Uint32 palette_channels_(const float red, const float green, const float blue)
+{
+    return 0xFF000000 | (Uint32)(255 * MIN(MAX(red,   0.f), 1.f)) << 16 
+                      | (Uint32)(255 * MIN(MAX(green, 0.f), 1.f)) << 8 
+                      | (Uint32)(255 * MIN(MAX(blue,  0.f), 1.f));
+}
 
-        for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
-        {
-            __m256 y0 = _mm256_sub_ps(_mm256_set1_ps((float)y_screen * SCALE), Y_OFFSET);
-    
-            for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; x_screen += SIMD_OBJS_CNT)
-            {
-                __m256 x0 = _mm256_add_ps(NATURAL08, _mm256_set1_ps((float)x_screen + 8*0));
-                       x0 = _mm256_sub_ps(_mm256_mul_ps(x0, SCALE_VEC), X_OFFSET); 
-                
-                volatile __m256 iter = _mm256_setzero_ps(); 
-                __m256 x = x0;
-                __m256 y = y0;
-
-                for (size_t i = 0; i < ITERS_CNT; ++i) {
-                    __m256 xx = _mm256_mul_ps(x, x);
-                    __m256 yy = _mm256_mul_ps(y, y);
-                    __m256 xy = _mm256_mul_ps(x, y);
-                    
-                    __m256 cmp = _mm256_cmp_ps(_mm256_add_ps(xx, yy), R_CIRCLE_INF2_VEC, _CMP_LE_OQ); 
-
-                    if (_mm256_testz_ps(cmp, cmp)) 
-                        break;
-                    
-                    iter = _mm256_add_ps(iter, _mm256_and_ps(cmp, ONE)); 
-                    x = _mm256_add_ps(_mm256_sub_ps(xx, yy), x0);
-                    y = _mm256_fmadd_ps(xy, TWO, y0);
-                }
+static float palette_t_(const size_t entry)
+{
+    return (float)entry / (float)(START_ITERS_CNT - 1);
+}
 
-                if (flags_objs->use_graphics)
-                {
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i)
-                    {
-                        const size_t pixel_addr = (y_screen) * (size_t)(pitch >> 2) + x_screen + i;
-                
-                        pixels[pixel_addr] = get_color(iter[i]);
+static Uint32 palette_fire_(const size_t entry)
+{
+    const float t = palette_t_(entry);
+    return palette_channels_(3 * t, 3 * t - 1, 3 * t - 2);
+}
 
-                    }         
-                }
-            }
-        }
-    }
+static Uint32 palette_ice_(const size_t entry)
+{
+    const float t = palette_t_(entry);
+    return palette_channels_(3 * t - 2, 3 * t - 1, 3 * t);
+}
 
-    if (flags_objs->use_graphics)
-    {
-        SDL_UnlockTexture(pixels_texture);
-    }
+static Uint32 palette_gray_(const size_t entry)
+{
+    const float t = palette_t_(entry);
+    return palette_channels_(t, t, t);
+}
 
-    return MANDELBRAT2_ERROR_SUCCESS;
+// periodic in entry, so cycling it has no seam
+static Uint32 palette_rainbow_(const size_t entry)
+{
+    const float phase = 2 * (float)M_PI * (float)entry / (float)START_ITERS_CNT;
+    return palette_channels_(0.5f + 0.5f * sinf(phase), 
+                             0.5f + 0.5f * sinf(phase + 2 * (float)M_PI / 3), 
+                             0.5f + 0.5f * sinf(phase + 4 * (float)M_PI / 3));
 }
 
-#endif /*UNROLL*/
+static const struct
+{
+    const char* name;
+    Uint32 (*color)(const size_t entry);
+} PALETTES_[] = {
+    {"settings",    palette_settings_},
+    {"fire",        palette_fire_},
+    {"ice",         palette_ice_},
+    {"gray",        palette_gray_},
+    {"rainbow",     palette_rainbow_},
+};
+
+size_t mandelbrat2_palettes_cnt(void)
+{
+    return sizeof(PALETTES_) / sizeof(*PALETTES_);
+}
 
-#else /*X86*/
+const char* mandelbrat2_palette_name(const size_t palette)
+{
+    lassert(palette < mandelbrat2_palettes_cnt(), "");
 
-#ifndef __aligned
-#define __aligned __attribute__((aligned(32)))
-#endif
+    return PALETTES_[palette].name;
+}
 
-#define UNROLL_CNT 4
-#define SIMD_OBJS_CNT 8 
-enum Mandelbrat2Error print_frame(SDL_Texture* pixels_texture, 
-                                  const mandelbrat2_state_t* const state,
-                                  const flags_objs_t* const flags_objs)
+size_t mandelbrat2_palette_find(const char* const name)
 {
-    if (flags_objs->use_graphics)
+    lassert(!is_invalid_ptr(name), "");
+
+    const char* const find_name = (*name == '\0') ? PALETTES_[0].name : name;
+
+    for (size_t palette = 0; palette < mandelbrat2_palettes_cnt(); ++palette)
     {
-        lassert(!is_invalid_ptr(pixels_texture), "");
-    }   
-    lassert(!is_invalid_ptr(state), "");
-    lassert(!is_invalid_ptr(flags_objs), "");
+        if (strcmp(PALETTES_[palette].name, find_name) == 0)
+            return palette;
+    }
 
-    const float SCALE           = 1.0f / state->scale;
-    const size_t REP_CNT        = flags_objs->rep_calc_frame_cnt;
-    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
-    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width - (SIMD_OBJS_CNT*UNROLL_CNT - 1);
-    const size_t ITERS_CNT      = state->iters_cnt;
+    return mandelbrat2_palettes_cnt();
+}
 
-    float R_CIRCLE_INF2_VEC[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { R_CIRCLE_INF2_VEC[i] = state->r_circle_inf * state->r_circle_inf; }
-    
-    float SCALE_VEC[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { SCALE_VEC[i] = SCALE; }
-    
-    float X_OFFSET[SIMD_OBJS_CNT]  __aligned = {}; 
-#pragma omp simd 
-    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { X_OFFSET[i] = state->x_offset * SCALE; }
-    
-    float Y_OFFSET[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { Y_OFFSET[i] = state->y_offset * SCALE; }
+// only the START_ITERS_CNT + 1 entries are rebuilt, the retained counts are recoloured by the next frame
+void mandelbrat2_set_palette(mandelbrat2_state_t* const state, const size_t palette, const size_t offset)
+{
+    lassert(!is_invalid_ptr(state), "");
+    lassert(palette < mandelbrat2_palettes_cnt(), "");
 
-    float NATURAL08[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { NATURAL08[i] = (float)i; }
+    Uint32 (* const color)(const size_t) = PALETTES_[palette].color;
 
-    void *pixels_void __aligned = NULL;
-    int pitch = 0;
+    state->palette_index    = palette;
+    state->palette_offset   = offset % START_ITERS_CNT;
+    ++state->palette_version;
 
-    if (flags_objs->use_graphics)
+    for (size_t entry = 0; entry <= START_ITERS_CNT; ++entry)
     {
-        SDL_ERROR_HANDLE_(SDL_LockTexture(pixels_texture, NULL, &pixels_void, &pitch));
+        state->palette[entry] = color((entry + state->palette_offset) % START_ITERS_CNT);
     }
 
-    Uint32* pixels __aligned = (Uint32*)pixels_void;
+    const Uint32 LAST_COLOR = color(START_ITERS_CNT - 1);
+    state->palette_span = START_ITERS_CNT - 1;
+    while (state->palette_span > 0 && color(state->palette_span - 1) == LAST_COLOR)
+        --state->palette_span;
+}
 
-    
-    for (size_t repeat = 0; repeat < REP_CNT; ++repeat)
-    {
+size_t mandelbrat2_formulas_cnt(void)
+{
+    return sizeof(FORMULAS_) / sizeof(*FORMULAS_);
+}
 
-// #ifdef COMPILE_OPTIMIZED
-// #pragma omp parallel for collapse(1) schedule(guided)
-// #endif /*COMPILE_OPTIMIZED*/
+const char* mandelbrat2_formula_name(const size_t formula)
+{
+    lassert(formula < mandelbrat2_formulas_cnt(), "");
 
-        for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
-        {
-            float y01[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y01[i] = (float)y_screen * SCALE; }
-#pragma omp simd
-            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y01[i] -= Y_OFFSET[i]; }
+    return FORMULAS_[formula].name;
+}
 
-            float y02[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y02[i] = y01[i]; }
-            float y03[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y03[i] = y01[i]; }
-            float y04[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-            for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y04[i] = y01[i]; }
-    
+size_t mandelbrat2_formula_find(const char* const name)
+{
+    lassert(!is_invalid_ptr(name), "");
 
-            for (size_t x_screen = 0; x_screen < SCREEN_WIDTH; x_screen += SIMD_OBJS_CNT*UNROLL_CNT)
-            {
-                float x01[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] = (float)x_screen + 8*(1 - 1); }
-                float x02[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] = (float)x_screen + 8*(2 - 1); }
-                float x03[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] = (float)x_screen + 8*(3 - 1); }
-                float x04[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd 
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] = (float)x_screen + 8*(4 - 1); }
-                
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] += NATURAL08[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] += NATURAL08[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] += NATURAL08[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] += NATURAL08[i]; }
+    const char* const find_name = (*name == '\0') ? FORMULAS_[MANDELBRAT2_FORMULA_MANDELBROT].name : name;
 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] *= SCALE_VEC[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] *= SCALE_VEC[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] *= SCALE_VEC[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] *= SCALE_VEC[i]; }
+    for (size_t formula = 0; formula < mandelbrat2_formulas_cnt(); ++formula)
+    {
+        if (strcmp(FORMULAS_[formula].name, find_name) == 0)
+            return formula;
+    }
 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x01[i] -= X_OFFSET[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x02[i] -= X_OFFSET[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x03[i] -= X_OFFSET[i]; }
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x04[i] -= X_OFFSET[i]; }    
+    return mandelbrat2_formulas_cnt();
+}
 
-                volatile float iter1[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};
-                volatile float iter2[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};
-                volatile float iter3[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};
-                volatile float iter4[SIMD_OBJS_CNT] __aligned = {0, 0, 0, 0, 0, 0, 0, 0};  
+// the kernel is switched with the formula, the next frame computes from scratch
+void mandelbrat2_set_formula(mandelbrat2_state_t* const state, const size_t formula)
+{
+    lassert(!is_invalid_ptr(state), "");
+    lassert(formula < mandelbrat2_formulas_cnt(), "");
 
+    const char* const kernel_name = state->use_julia ? FORMULAS_[formula].julia_kernel_name 
+                                                     : FORMULAS_[formula].kernel_name;
 
-                float x1[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x1[i] = x01[i]; } 
-                float x2[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x2[i] = x02[i]; } 
-                float x3[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x3[i] = x03[i]; } 
-                float x4[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x4[i] = x04[i]; } 
+    state->formula  = formula;
+    state->kernel   = kernel_name ? mandelbrat2_kernel_find(kernel_name) : state->mandelbrot_kernel;
 
+    lassert(state->kernel < mandelbrat2_kernels_cnt(), "");
+}
 
-                float y1[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y1[i] = y01[i]; } 
-                float y2[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y2[i] = y02[i]; } 
-                float y3[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y3[i] = y03[i]; } 
-                float y4[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y4[i] = y04[i]; } 
+// entering takes c under the pixel and starts from the whole set, leaving restores the view it was taken in
+void mandelbrat2_toggle_julia(mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs,
+                              const int x_screen, const int y_screen)
+{
+    lassert(!is_invalid_ptr(state), "");
+    lassert(!is_invalid_ptr(flags_objs), "");
 
+    state->use_julia = !state->use_julia;
 
-                for (size_t iter_cnt = 0; iter_cnt < ITERS_CNT; ++iter_cnt)
-                {
-                    float xx1[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx1[i] = x1[i] * x1[i]; } 
-                    float xx2[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx2[i] = x2[i] * x2[i]; } 
-                    float xx3[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx3[i] = x3[i] * x3[i]; } 
-                    float xx4[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xx4[i] = x4[i] * x4[i]; } 
-                    
+    if (state->use_julia)
+    {
+        state->mandelbrot_scale     = state->scale;
+        state->mandelbrot_x_offset  = state->x_offset;
+        state->mandelbrot_y_offset  = state->y_offset;
+        mandelbrat2_set_julia_c(state, x_screen, y_screen);
 
-                    float yy1[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy1[i] = y1[i] * y1[i]; }
-                    float yy2[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy2[i] = y2[i] * y2[i]; }
-                    float yy3[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy3[i] = y3[i] * y3[i]; }
-                    float yy4[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { yy4[i] = y4[i] * y4[i]; }
+        state->scale    = START_SCALE;
+        state->x_offset = (float)(flags_objs->screen_width  >> 1);
+        state->y_offset = (float)(flags_objs->screen_height >> 1);
+    }
+    else
+    {
+        state->scale    = state->mandelbrot_scale;
+        state->x_offset = state->mandelbrot_x_offset;
+        state->y_offset = state->mandelbrot_y_offset;
+    }
 
+    mandelbrat2_set_formula(state, state->formula);
+}
 
-                    float xy1[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy1[i] = x1[i] * y1[i]; }
-                    float xy2[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy2[i] = x2[i] * y2[i]; }
-                    float xy3[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy3[i] = x3[i] * y3[i]; }
-                    float xy4[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { xy4[i] = x4[i] * y4[i]; }
+void mandelbrat2_set_julia_c(mandelbrat2_state_t* const state, const int x_screen, const int y_screen)
+{
+    lassert(!is_invalid_ptr(state), "");
 
+    state->julia_x = ((float)x_screen - state->mandelbrot_x_offset) / state->mandelbrot_scale;
+    state->julia_y = ((float)y_screen - state->mandelbrot_y_offset) / state->mandelbrot_scale;
+}
 
-                    float sum21[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum21[i] = xx1[i] + yy1[i]; }
-                    float sum22[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum22[i] = xx2[i] + yy2[i]; }
-                    float sum23[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum23[i] = xx3[i] + yy3[i]; }
-                    float sum24[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { sum24[i] = xx4[i] + yy4[i]; }
-                    
+static void count_pixel_(mandelbrat2_workload_t* const workload, const size_t iter, const size_t iters_cnt)
+{
+    workload->useful_iters += iter;
 
-                    float cmp1[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp1[i] = (sum21[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
-                    float cmp2[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp2[i] = (sum22[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
-                    float cmp3[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp3[i] = (sum23[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
-                    float cmp4[SIMD_OBJS_CNT] __aligned = {}; 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp4[i] = (sum24[i] <= R_CIRCLE_INF2_VEC[i] ? -1.f : 0.f); }
+    if (iter >= iters_cnt)
+        ++workload->interior_cnt;
+    else
+        ++workload->hist[iter / workload->hist_bin_width];
+}
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wstrict-aliasing"
-                    uint32_t cmp_acc1 = 0; 
-#pragma omp simd reduction(|:cmp_acc1)
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc1 |= *(uint32_t*)&cmp1[i]; }
-                    int cmp_rez1 = (cmp_acc1 == 0); 
-                    uint32_t cmp_acc2 = 0;
-#pragma omp simd reduction(|:cmp_acc2)
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc2 |= *(uint32_t*)&cmp2[i]; }
-                    int cmp_rez2 = (cmp_acc2 == 0); 
-                    uint32_t cmp_acc3 = 0; 
-#pragma omp simd reduction(|:cmp_acc3)
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc3 |= *(uint32_t*)&cmp3[i]; }
-                    int cmp_rez3 = (cmp_acc3 == 0);
-                    uint32_t cmp_acc4 = 0; 
-#pragma omp simd reduction(|:cmp_acc4)
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { cmp_acc4 |= *(uint32_t*)&cmp4[i]; }
-                    int cmp_rez4 = (cmp_acc4 == 0);
-#pragma GCC diagnostic pop
+// trips of a batch are derived from its counts: the loop stops one trip after the slowest lane
+// escapes, or after ITERS_CNT trips. The right and bottom remainder the scalar pass computes is
+// counted per pixel into tail_iters, so every pixel of the frame is in the counts.
+void mandelbrat2_count_workload(const uint32_t* const iters, const mandelbrat2_state_t* const state,
+                                const flags_objs_t* const flags_objs,
+                                mandelbrat2_workload_t* const workload)
+{
+    lassert(!is_invalid_ptr(iters), "");
+    lassert(!is_invalid_ptr(state), "");
+    lassert(!is_invalid_ptr(flags_objs), "");
+    lassert(!is_invalid_ptr(workload), "");
 
-                    if (cmp_rez1 && cmp_rez2 && cmp_rez3 && cmp_rez4) 
-                        break;
-                    
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter1[i] += (cmp1[i] != 0.0f) ? 1.0f : 0.0f; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter2[i] += (cmp2[i] != 0.0f) ? 1.0f : 0.0f; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter3[i] += (cmp3[i] != 0.0f) ? 1.0f : 0.0f; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter4[i] += (cmp4[i] != 0.0f) ? 1.0f : 0.0f; }
+    const size_t SCREEN_HEIGHT  = (size_t)flags_objs->screen_height;
+    const size_t SCREEN_WIDTH   = (size_t)flags_objs->screen_width;
+    const size_t ITERS_CNT      = state->iters_cnt;
+    const size_t BLOCK_WIDTH    = mandelbrat2_kernel(state->kernel)->block_width;
+    const size_t BLOCK_HEIGHT   = mandelbrat2_kernel(state->kernel)->block_height;
+    const size_t BLOCKS_WIDTH   = SCREEN_WIDTH  / BLOCK_WIDTH  * BLOCK_WIDTH;
+    const size_t BLOCKS_HEIGHT  = SCREEN_HEIGHT / BLOCK_HEIGHT * BLOCK_HEIGHT;
 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x1[i] = (xx1[i] - yy1[i]) + x01[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x2[i] = (xx2[i] - yy2[i]) + x02[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x3[i] = (xx3[i] - yy3[i]) + x03[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { x4[i] = (xx4[i] - yy4[i]) + x04[i]; }
+    memset(workload, 0, sizeof(*workload));
+    workload->lanes             = BLOCK_WIDTH * BLOCK_HEIGHT;
+    workload->hist_bin_width    = MAX((ITERS_CNT + MANDELBRAT2_HIST_BINS - 1) / MANDELBRAT2_HIST_BINS, 1lu);
 
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y1[i] = xy1[i] * 2.0f + y01[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y2[i] = xy2[i] * 2.0f + y02[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y3[i] = xy3[i] * 2.0f + y03[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { y4[i] = xy4[i] * 2.0f + y04[i]; }
+    for (size_t y_screen = 0; y_screen < BLOCKS_HEIGHT; y_screen += BLOCK_HEIGHT)
+    {
+        for (size_t x_screen = 0; x_screen < BLOCKS_WIDTH; x_screen += BLOCK_WIDTH)
+        {
+            size_t batch_max = 0;
 
-                }
+            for (size_t y_lane = 0; y_lane < BLOCK_HEIGHT; ++y_lane)
+            {
+                const uint32_t* const iters_row = iters + (y_screen + y_lane) * SCREEN_WIDTH + x_screen;
 
-                if (flags_objs->use_graphics)
+                for (size_t x_lane = 0; x_lane < BLOCK_WIDTH; ++x_lane)
                 {
-                    float iter[UNROLL_CNT*SIMD_OBJS_CNT] __aligned = {};
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(1-1)] = iter1[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(2-1)] = iter2[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(3-1)] = iter3[i]; }
-#pragma omp simd
-                    for (size_t i = 0; i < SIMD_OBJS_CNT; ++i) { iter[i + SIMD_OBJS_CNT*(4-1)] = iter4[i]; }
-
-                    for (size_t i = 0; i < SIMD_OBJS_CNT*UNROLL_CNT; ++i)
-                    {
-                        const size_t pixel_addr = (y_screen) * (size_t)(pitch >> 2) + x_screen + i;
-                
-                        pixels[pixel_addr] = get_color(iter[i]);
-
-                    }         
+                    count_pixel_(workload, iters_row[x_lane], ITERS_CNT);
+                    batch_max = MAX(batch_max, (size_t)iters_row[x_lane]);
                 }
             }
+
+            workload->vector_iters += MIN(batch_max + 1, ITERS_CNT);
         }
     }
 
-    if (flags_objs->use_graphics)
+    for (size_t y_screen = 0; y_screen < SCREEN_HEIGHT; ++y_screen)
     {
-        SDL_UnlockTexture(pixels_texture);
-    }
+        const uint32_t* const iters_row = iters + y_screen * SCREEN_WIDTH;
 
-    return MANDELBRAT2_ERROR_SUCCESS;
+        for (size_t x_screen = y_screen < BLOCKS_HEIGHT ? BLOCKS_WIDTH : 0; x_screen < SCREEN_WIDTH; ++x_screen)
+        {
+            count_pixel_(workload, iters_row[x_screen], ITERS_CNT);
+            workload->tail_iters += MIN((size_t)iters_row[x_screen] + 1, ITERS_CNT);
+        }
+    }
 }
 
-#endif /*X86*/
+double mandelbrat2_lane_utilization(const mandelbrat2_workload_t* const workload)
+{
+    lassert(!is_invalid_ptr(workload), "");
+
+    const uint64_t lane_iters = workload->vector_iters * workload->lanes + workload->tail_iters;
 
-#endif /*__AVX2__*/
\ No newline at end of file
+    return lane_iters ? (double)workload->useful_iters / (double)lane_iters : 0;
+}
@@ -2,6 +2,7 @@
 #define MANDELBRAT2_SRC_MANDELBRAT2_MANDELBRAT2_H
 
 #include <assert.h>
+#include <stdint.h>
 
 #include <SDL2/SDL.h>
 
@@ -12,6 +13,10 @@ enum Mandelbrat2Error
     MANDELBRAT2_ERROR_SUCCESS           = 0,
     MANDELBRAT2_ERROR_SDL               = 1,
     MANDELBRAT2_ERROR_STANDARD_ERRNO    = 2,
+    MANDELBRAT2_ERROR_UNKNOWN_KERNEL    = 3,
+    MANDELBRAT2_ERROR_UNKNOWN_PALETTE   = 4,
+    MANDELBRAT2_ERROR_UNKNOWN_FORMULA   = 5,
+    MANDELBRAT2_ERROR_AFFINITY          = 6,
 };
 static_assert(MANDELBRAT2_ERROR_SUCCESS  == 0, "");
 
@@ -29,6 +34,159 @@ const char* mandelbrat2_strerror(const enum Mandelbrat2Error error);
         }                                                                                           \
     } while(0)
 
+#define MANDELBRAT2_TILE_SIZE 32
+
+// the vector kernels count in float lanes, exact up to 2^24
+#define MANDELBRAT2_ITERS_CNT_MAX (1lu << 24)
+
+#define MANDELBRAT2_AUTO_ITERS_MIN 32
+#define MANDELBRAT2_AUTO_ITERS_MAX (1lu << 16)
+
+typedef struct Mandelbrat2Rect
+{
+    size_t x;
+    size_t y;
+    size_t width;
+    size_t height;
+} mandelbrat2_rect_t;
+
+typedef struct Mandelbrat2TileJob
+{
+    uint64_t cost;      // predicted tiks
+    size_t tile;
+} mandelbrat2_tile_job_t;
+
+#define MANDELBRAT2_RESUME_BATCH 8
+
+// pixels still bounded after iters_cnt iterations with their last z, so a higher budget continues
+// them instead of starting over. The list is padded up to whole batches with lanes that escape at once.
+typedef struct Mandelbrat2Resume
+{
+    size_t cnt;
+    uint32_t* pixels;
+    float* x;
+    float* y;
+    float* x0;
+    float* y0;
+
+    bool is_valid;
+    size_t iters_cnt;
+    float r_circle_inf;
+    float scale;
+    float x_offset;
+    float y_offset;
+} mandelbrat2_resume_t;
+
+enum Mandelbrat2Coloring
+{
+    MANDELBRAT2_COLORING_ITERS      = 0,
+    MANDELBRAT2_COLORING_SMOOTH     = 1,
+    MANDELBRAT2_COLORING_HISTOGRAM  = 2,
+};
+
+#define MANDELBRAT2_HISTOGRAM_BINS_MAX (1lu << 16)
+
+// equalized colouring: counts are binned by count >> shift, every thread fills its own row of bins,
+// row 0 receives their sum and colors maps each bin to the palette by its share of the exterior
+typedef struct Mandelbrat2Histogram
+{
+    size_t threads_cnt;
+    uint32_t* thread_bins;
+    Uint32* colors;         // bins_cnt entries and the interior colour after them
+    size_t bins_cnt;
+    size_t shift;
+} mandelbrat2_histogram_t;
+
+#define MANDELBRAT2_ANTIALIAS_THRESHOLD     2
+#define MANDELBRAT2_ANTIALIAS_SAMPLES       8
+#define MANDELBRAT2_ANTIALIAS_ITERS_BUDGET  (1lu << 22)     // subsample vector iterations per frame
+
+// pixels whose count differs from a 4-neighbour by more than threshold, with their supersampled
+// colours. The first frame of a view shows the aliased image, the next ones refine edges [done_cnt, ...)
+// within the budget and skip the compute while the view stays the same.
+typedef struct Mandelbrat2Antialias
+{
+    size_t edges_cnt;
+    size_t done_cnt;
+    uint32_t* edges;
+    uint32_t* colors;
+
+    bool is_valid;
+    size_t iters_cnt;
+    float r_circle_inf;
+    float scale;
+    float x_offset;
+    float y_offset;
+    enum Mandelbrat2Coloring coloring;
+    size_t palette_version;     // done colours are dropped when the palette changes
+} mandelbrat2_antialias_t;
+
+#define MANDELBRAT2_BUDDHA_CHANNELS         3
+#define MANDELBRAT2_BUDDHA_CHANNEL_SHIFT    2           // channel k counts orbits escaping within iters_cnt >> 2k
+#define MANDELBRAT2_BUDDHA_MIN_ITERS        4           // shorter orbits only haze the plane around c
+#define MANDELBRAT2_BUDDHA_ITERS_BUDGET     (1lu << 22) // sample vector iterations per thread and frame
+#define MANDELBRAT2_BUDDHA_BANDS            64          // row bands of the grid the orbit points are queued by
+#define MANDELBRAT2_BUDDHA_QUEUE_SIZE       1024        // points a thread holds for a band before a merge
+
+// Buddhabrot density of the orbits of random escaping c, the channels are the Nebulabrot red, green and blue.
+// Sampling runs in rounds: every thread queues its orbit points by row band until one of its queues
+// fills, then every band is merged into grid by a single thread, so the merge costs as much as the
+// samples, not the screen. The accumulation starts over when the view changes.
+typedef struct Mandelbrat2Buddha
+{
+    size_t threads_cnt;
+    uint32_t* queues;           // threads_cnt x BANDS queues of pixel << 2 | channels_cnt
+    uint32_t* queues_cnt;       // threads_cnt x BANDS
+    uint64_t* grid;             // MANDELBRAT2_BUDDHA_CHANNELS planes
+    uint64_t max[MANDELBRAT2_BUDDHA_CHANNELS];
+    uint64_t* rng;              // xorshift state of every thread, a cache line apart
+    uint64_t samples_cnt;
+
+    bool is_valid;
+    size_t iters_cnt;
+    float r_circle_inf;
+    float scale;
+    float x_offset;
+    float y_offset;
+} mandelbrat2_buddha_t;
+
+#define MANDELBRAT2_ARENA_ALIGN     64
+#define MANDELBRAT2_HUGE_PAGE_SIZE  (2lu << 20)
+
+// one mapping holds every buffer sized by the resolution, cache line aligned. A resize lays them out
+// again in it and maps a new one only when they do not fit, so frames themselves never allocate.
+// The escape |z|^2 and antialias regions are reserved from the first frame that needs them on.
+typedef struct Mandelbrat2Arena
+{
+    char* base;
+    size_t capacity;
+    size_t used;
+    bool use_huge_pages;        // transparent huge pages, the mapping is 2MB aligned for them
+    bool has_escape_zz;
+    bool has_antialias;
+    int width;
+    int height;
+} mandelbrat2_arena_t;
+
+// the view the retained counts were computed in, a frame in it with only the palette changed is recoloured
+typedef struct Mandelbrat2FrameView
+{
+    bool is_valid;
+    size_t iters_cnt;
+    float r_circle_inf;
+    float scale;
+    float x_offset;
+    float y_offset;
+    bool has_escape_zz;
+    size_t formula;
+    bool use_julia;
+    float julia_x;
+    float julia_y;
+    size_t palette_version;     // of the last colouring
+} mandelbrat2_frame_view_t;
+
+#define MANDELBRAT2_FORMULA_MANDELBROT 0
+
 typedef struct Mandelbrat2State
 {
     size_t iters_cnt;
@@ -38,14 +196,155 @@ typedef struct Mandelbrat2State
     float x_offset;
     float y_offset;
 
+    size_t kernel;
+    size_t escape_check_period;     // iterations between escape tests in the deferred kernel
+
+    // z^2 + c computes with mandelbrot_kernel, the other formulas with their generated kernel
+    size_t formula;
+    size_t mandelbrot_kernel;
+
+    // Julia mode iterates from z at the pixel with c fixed, c is picked in the view saved on entering it
+    bool use_julia;
+    float julia_x;
+    float julia_y;
+    float mandelbrot_scale;
+    float mandelbrot_x_offset;
+    float mandelbrot_y_offset;
+
+    mandelbrat2_arena_t arena;
+    uint32_t* iters;
+
+    int* thread_cpus;           // the cpu every render thread is pinned to, AFFINITY_NO_CPU when it is not
+
+    size_t tiles_x;
+    size_t tiles_y;
+    uint64_t* tile_costs;
+    uint64_t* tile_costs_sum;
+    size_t tile_costs_frames_cnt;
+    bool show_heatmap;
+
+    // costs of the last tiled frame and the view they were measured in
+    uint64_t* prev_tile_costs;
+    bool has_prev_tile_costs;
+    float prev_scale;
+    float prev_x_offset;
+    float prev_y_offset;
+    mandelbrat2_tile_job_t* tile_jobs;
+
+    mandelbrat2_resume_t resume;
+
+    // escapes of the last frame close to its budget, they steer iters_cnt in the automatic mode
+    bool use_auto_iters;
+    size_t escapes_iters_cnt;
+    uint64_t escapes_upper_half_cnt;        // escaped in [iters_cnt/2, iters_cnt)
+    uint64_t escapes_upper_quarters_cnt;    // escaped in [iters_cnt/4, iters_cnt)
+
+    uint32_t* check_iters;      // brute force reference of a frame with filled pixels
+
+    // smooth colouring interpolates the palette by the fractional escape count from |z|^2 at escape
+    bool use_smooth;
+    float* escape_zz;
+    // entries of the chosen palette rotated by offset, with the first of them repeated after the last
+    uint32_t* palette;
+    size_t palette_span;        // first entry from which the unrotated palette stays the same
+    size_t palette_index;
+    size_t palette_offset;
+    size_t palette_version;
+    bool use_palette_cycle;     // the offset steps by one entry every frame
+
+    mandelbrat2_frame_view_t frame_view;
+
+    bool use_histogram;
+    mandelbrat2_histogram_t histogram;
+
+    bool use_antialias;
+    size_t antialias_threshold;
+    mandelbrat2_antialias_t antialias;
+
+    bool use_buddha;
+    bool use_nebula;            // colours the three channels instead of a gray first one
+    mandelbrat2_buddha_t buddha;
+
 } mandelbrat2_state_t;
 
+typedef void (*mandelbrat2_kernel_t)(uint32_t* const iters, const size_t iters_pitch,
+                                     const mandelbrat2_state_t* const state,
+                                     const mandelbrat2_rect_t* const rect);
+
+typedef struct Mandelbrat2KernelInfo
+{
+    const char* name;
+    mandelbrat2_kernel_t compute;
+    mandelbrat2_kernel_t tail;  // scalar kernel for the pixels that do not fill a whole block
+    size_t block_width;     // pixels that leave the iteration loop together
+    size_t block_height;
+    bool is_mandelbrot;     // z^2 + c with c at the pixel, the only kernels the bench scenes are for
+    bool has_escape_zz;     // also writes |z|^2 of the escape step to state->escape_zz
+} mandelbrat2_kernel_info_t;
+
+size_t                              mandelbrat2_kernels_cnt(void);
+const mandelbrat2_kernel_info_t*    mandelbrat2_kernel     (const size_t kernel);
+size_t                              mandelbrat2_kernel_find(const char* const name);
+
+// the kernel computes the whole blocks of rect, its tail kernel the right and bottom remainder
+void mandelbrat2_compute_rect(const mandelbrat2_kernel_info_t* const kernel, uint32_t* const iters,
+                              const size_t iters_pitch, const mandelbrat2_state_t* const state,
+                              const mandelbrat2_rect_t* const rect);
+
+size_t      mandelbrat2_palettes_cnt    (void);
+const char* mandelbrat2_palette_name    (const size_t palette);
+size_t      mandelbrat2_palette_find    (const char* const name);
+void        mandelbrat2_set_palette     (mandelbrat2_state_t* const state, const size_t palette, 
+                                         const size_t offset);
+
+size_t      mandelbrat2_formulas_cnt    (void);
+const char* mandelbrat2_formula_name    (const size_t formula);
+size_t      mandelbrat2_formula_find    (const char* const name);
+void        mandelbrat2_set_formula     (mandelbrat2_state_t* const state, const size_t formula);
+
+void        mandelbrat2_toggle_julia    (mandelbrat2_state_t* const state, const flags_objs_t* const flags_objs,
+                                         const int x_screen, const int y_screen);
+void        mandelbrat2_set_julia_c     (mandelbrat2_state_t* const state, const int x_screen, const int y_screen);
+
+#define MANDELBRAT2_HIST_BINS 32
+
+typedef struct Mandelbrat2Workload
+{
+    uint64_t useful_iters;
+    uint64_t vector_iters;
+    uint64_t tail_iters;    // scalar trips of the pixels outside whole blocks
+    size_t lanes;
+
+    size_t hist_bin_width;
+    uint64_t hist[MANDELBRAT2_HIST_BINS];
+    uint64_t interior_cnt;
+} mandelbrat2_workload_t;
+
+void   mandelbrat2_count_workload      (const uint32_t* const iters, 
+                                        const mandelbrat2_state_t* const state,
+                                        const flags_objs_t* const flags_objs,
+                                        mandelbrat2_workload_t* const workload);
+double mandelbrat2_lane_utilization    (const mandelbrat2_workload_t* const workload);
+
 enum Mandelbrat2Error mandelbrat2_state_ctor(mandelbrat2_state_t* const state, 
                                              const flags_objs_t* const flags_objs);
+void                  mandelbrat2_state_dtor(mandelbrat2_state_t* const state);
+
+// flags_objs carries the new screen size
+enum Mandelbrat2Error mandelbrat2_state_resize(mandelbrat2_state_t* const state, 
+                                               const flags_objs_t* const flags_objs);
+
+// reserves the buffers that state's kernel, smooth colouring and antialiasing need, the first
+// reservation drops the retained views like a resize
+enum Mandelbrat2Error mandelbrat2_state_reserve(mandelbrat2_state_t* const state, 
+                                                const flags_objs_t* const flags_objs);
 
 enum Mandelbrat2Error print_frame(SDL_Texture* pixels_texture, 
-                                  const mandelbrat2_state_t* const state,
+                                  mandelbrat2_state_t* const state,
                                   const flags_objs_t* const flags_objs);
 
+enum Mandelbrat2Error mandelbrat2_dump_tile_costs(const mandelbrat2_state_t* const state,
+                                                  const char* const filename);
+
 
 #endif /* MANDELBRAT2_SRC_MANDELBRAT2_MANDELBRAT2_H */
\ No newline at end of file
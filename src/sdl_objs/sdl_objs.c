@@ -13,6 +13,7 @@ const char* sdl_objs_strerror(const enum SdlObjsError error)
         CASE_ENUM_TO_STRING_(SDL_OBJS_ERROR_SUCCESS);
         CASE_ENUM_TO_STRING_(SDL_OBJS_ERROR_SDL);
         CASE_ENUM_TO_STRING_(SDL_OBJS_ERROR_TTF);
+        CASE_ENUM_TO_STRING_(SDL_OBJS_ERROR_RESIZE);
         default:
             return "UNKNOWN_SDL_OBJS_ERROR";
     }
@@ -58,7 +59,7 @@ enum SdlObjsError sdl_objs_ctor(sdl_objs_t* const sdl_objs, const flags_objs_t *
         (flags_objs->screen_y_offset == -1 ? (int)SDL_WINDOWPOS_CENTERED : flags_objs->screen_y_offset), 
         flags_objs->screen_width, 
         flags_objs->screen_height, 
-        SDL_WINDOW_SHOWN
+        SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
     );
 
     if (!sdl_objs->window)
@@ -127,9 +128,48 @@ void sdl_objs_dtor(sdl_objs_t* const sdl_objs)
     SDL_Quit            ();
 }
 
-enum SdlObjsError sdl_handle_events(SDL_Event* event, const flags_objs_t * const flags_objs,
+// the frame buffers are laid out again in the same arena, only the texture is recreated
+static enum SdlObjsError resize_(sdl_objs_t* const sdl_objs, flags_objs_t* const flags_objs,
+                                 mandelbrat2_state_t* const state, const int width, const int height)
+{
+    if (width <= 0 || height <= 0 
+        || (width == flags_objs->screen_width && height == flags_objs->screen_height))
+        return SDL_OBJS_ERROR_SUCCESS;
+
+    SDL_Texture* const pixels_texture = SDL_CreateTexture(
+        sdl_objs->renderer, 
+        SDL_PIXELFORMAT_RGBA32, 
+        SDL_TEXTUREACCESS_STREAMING, 
+        width, 
+        height
+    );
+
+    if (!pixels_texture)
+    {
+        fprintf(stderr, "Can`t SDL_CreateTexture. Error: %s\n", SDL_GetError());
+        return SDL_OBJS_ERROR_SDL;
+    }
+
+    flags_objs->screen_width  = width;
+    flags_objs->screen_height = height;
+
+    if (mandelbrat2_state_resize(state, flags_objs))
+    {
+        SDL_DestroyTexture(pixels_texture);
+        return SDL_OBJS_ERROR_RESIZE;
+    }
+
+    SDL_DestroyTexture(sdl_objs->pixels_texture);
+    sdl_objs->pixels_texture = pixels_texture;
+
+    return SDL_OBJS_ERROR_SUCCESS;
+}
+
+enum SdlObjsError sdl_handle_events(sdl_objs_t* const sdl_objs, SDL_Event* event, 
+                                    flags_objs_t* const flags_objs,
                                     mandelbrat2_state_t* const state, SDL_bool* const quit)
 {
+    lassert(!is_invalid_ptr(sdl_objs), "");
     lassert(!is_invalid_ptr(event), "");
     lassert(!is_invalid_ptr(flags_objs), "");
     lassert(!is_invalid_ptr(state), "");
@@ -165,9 +205,70 @@ enum SdlObjsError sdl_handle_events(SDL_Event* event, const flags_objs_t * const
                             state->scale *= (1.f - SCALE_STEP * (float)(modifiers & KMOD_SHIFT));
                             break;
 
+                        case SDLK_h:        state->show_heatmap = !state->show_heatmap; break;
+
+                        case SDLK_RIGHTBRACKET:
+                            state->iters_cnt = MIN(state->iters_cnt * ITERS_STEP, MANDELBRAT2_ITERS_CNT_MAX);
+                            state->use_auto_iters = false;
+                            break;
+                        case SDLK_LEFTBRACKET:
+                            state->iters_cnt = MAX(state->iters_cnt / ITERS_STEP, (size_t)1);
+                            state->use_auto_iters = false;
+                            break;
+                        case SDLK_i:        state->use_auto_iters = !state->use_auto_iters; break;
+                        case SDLK_z:        state->use_smooth     = !state->use_smooth;     break;
+                        case SDLK_q:        state->use_antialias  = !state->use_antialias;  break;
+                        case SDLK_e:        state->use_histogram  = !state->use_histogram;  break;
+
+                        case SDLK_p:
+                            mandelbrat2_set_palette(state, (state->palette_index + 1) % mandelbrat2_palettes_cnt(),
+                                                           state->palette_offset);
+                            break;
+                        case SDLK_c:        state->use_palette_cycle = !state->use_palette_cycle; break;
+
+                        case SDLK_f:
+                            mandelbrat2_set_formula(state, (state->formula + 1) % mandelbrat2_formulas_cnt());
+                            break;
+                        case SDLK_j:
+                        {
+                            int mouse_x = 0, mouse_y = 0;
+                            SDL_GetMouseState(&mouse_x, &mouse_y);
+                            mandelbrat2_toggle_julia(state, flags_objs, mouse_x, mouse_y);
+                            break;
+                        }
+                        case SDLK_b:
+                            state->use_buddha = !state->use_buddha && state->buddha.grid;
+                            break;
+                        case SDLK_n:
+                            state->use_nebula = !state->use_nebula;
+                            break;
+
                         default: break;
                     }
                 }
+                break;
+            }
+
+            // dragging moves c over the view the Julia mode was entered from
+            case SDL_MOUSEMOTION:
+            {
+                if (flags_objs->use_graphics && state->use_julia && (event->motion.state & SDL_BUTTON_LMASK))
+                {
+                    mandelbrat2_set_julia_c(state, event->motion.x, event->motion.y);
+                }
+                break;
+            }
+
+            case SDL_WINDOWEVENT:
+            {
+                if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                {
+                    const enum SdlObjsError error = resize_(sdl_objs, flags_objs, state, 
+                                                            event->window.data1, event->window.data2);
+                    if (error)
+                        return error;
+                }
+                break;
             }
 
             default: break;
@@ -14,6 +14,7 @@ enum SdlObjsError
     SDL_OBJS_ERROR_SUCCESS          = 0,
     SDL_OBJS_ERROR_SDL              = 1,
     SDL_OBJS_ERROR_TTF              = 2,
+    SDL_OBJS_ERROR_RESIZE           = 3,
 };
 static_assert(SDL_OBJS_ERROR_SUCCESS  == 0, "");
 
@@ -43,7 +44,8 @@ typedef struct SdlObjs
 enum SdlObjsError sdl_objs_ctor(sdl_objs_t* const sdl_objs, const flags_objs_t * const flags_objs);
 void              sdl_objs_dtor(sdl_objs_t* const sdl_objs);
 
-enum SdlObjsError sdl_handle_events(SDL_Event* event, const flags_objs_t * const flags_objs,
+enum SdlObjsError sdl_handle_events(sdl_objs_t* const sdl_objs, SDL_Event* event, 
+                                    flags_objs_t* const flags_objs,
                                     mandelbrat2_state_t* const state, SDL_bool* const quit);
 
 #endif /* SDL_OBJS_SRC_SDL_OBJS_SDL_OBJS_H */
\ No newline at end of file
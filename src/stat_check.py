@@ -7,7 +7,7 @@ def read_data(filename):
     with open(filename, 'r') as f:
         for line in f:
             parts = line.strip().split()
-            if len(parts) == 2:
+            if len(parts) >= 2 and parts[0] != '#':
                 iterations.append(int(parts[0]))
                 cycles.append(int(parts[1]))
     return iterations, cycles
@@ -0,0 +1,134 @@
+#include <math.h>
+#include <string.h>
+
+#include "stats/stats.h"
+#include "logger/liblogger.h"
+#include "utils/utils.h"
+
+#define STATS_DRIFT_T_          2.3     // ~two-sided 95% Student t for 8 degrees of freedom
+#define STATS_DRIFT_REL_        0.005   // halves closer than this are stationary whatever t says
+#define STATS_OUTLIER_SIGMAS_   4.0
+#define STATS_MIN_CNT_          8
+#define STATS_Z_95_             1.96
+
+void stats_ctor(online_stats_t* const stats)
+{
+    lassert(!is_invalid_ptr(stats), "");
+
+    memset(stats->window, 0, sizeof(stats->window));
+    stats->window_cnt       = 0;
+
+    stats->is_stationary    = false;
+    stats->warmup_cnt       = 0;
+    stats->outliers_cnt     = 0;
+
+    stats->cnt              = 0;
+    stats->mean             = 0;
+    stats->m2               = 0;
+}
+
+static void half_mean_var_(const double* const half, const size_t cnt, double* const mean,
+                           double* const var)
+{
+    *mean = 0;
+    for (size_t sample = 0; sample < cnt; ++sample)
+    {
+        *mean += half[sample];
+    }
+    *mean /= (double)cnt;
+
+    *var = 0;
+    for (size_t sample = 0; sample < cnt; ++sample)
+    {
+        *var += (half[sample] - *mean) * (half[sample] - *mean);
+    }
+    *var /= (double)(cnt - 1);
+}
+
+// Welch t-test between older and newer half of the window
+static bool is_window_stationary_(const online_stats_t* const stats)
+{
+    const size_t HALF = STATS_WINDOW_SIZE / 2;
+
+    double old_mean = 0, old_var = 0, new_mean = 0, new_var = 0;
+    half_mean_var_(stats->window,        HALF, &old_mean, &old_var);
+    half_mean_var_(stats->window + HALF, HALF, &new_mean, &new_var);
+
+    const double diff = fabs(new_mean - old_mean);
+    if (diff <= STATS_DRIFT_REL_ * fabs(old_mean))
+        return true;
+
+    const double denominator = sqrt((old_var + new_var) / (double)HALF);
+    if (!(denominator > 0))
+        return false;
+
+    return diff / denominator < STATS_DRIFT_T_;
+}
+
+enum StatsSample stats_push(online_stats_t* const stats, const double sample)
+{
+    lassert(!is_invalid_ptr(stats), "");
+
+    if (!stats->is_stationary)
+    {
+        ++stats->warmup_cnt;
+
+        if (stats->window_cnt == STATS_WINDOW_SIZE)
+        {
+            memmove(stats->window, stats->window + 1, (STATS_WINDOW_SIZE - 1) * sizeof(*stats->window));
+            --stats->window_cnt;
+        }
+        stats->window[stats->window_cnt++] = sample;
+
+        stats->is_stationary = stats->window_cnt == STATS_WINDOW_SIZE && is_window_stationary_(stats);
+
+        return STATS_SAMPLE_WARMUP;
+    }
+
+    if (stats->cnt >= STATS_MIN_CNT_
+     && fabs(sample - stats->mean) > STATS_OUTLIER_SIGMAS_ * stats_stddev(stats))
+    {
+        ++stats->outliers_cnt;
+        return STATS_SAMPLE_OUTLIER;
+    }
+
+    ++stats->cnt;
+    const double delta = sample - stats->mean;
+    stats->mean += delta / (double)stats->cnt;
+    stats->m2   += delta * (sample - stats->mean);
+
+    return STATS_SAMPLE_ACCEPTED;
+}
+
+double stats_stddev(const online_stats_t* const stats)
+{
+    lassert(!is_invalid_ptr(stats), "");
+
+    return stats->cnt > 1 ? sqrt(stats->m2 / (double)(stats->cnt - 1)) : 0;
+}
+
+double stats_sem(const online_stats_t* const stats)
+{
+    lassert(!is_invalid_ptr(stats), "");
+
+    return stats->cnt > 1 ? stats_stddev(stats) / sqrt((double)stats->cnt) : 0;
+}
+
+double stats_ci_rel(const online_stats_t* const stats)
+{
+    lassert(!is_invalid_ptr(stats), "");
+
+    return stats->cnt > 1 && stats->mean > 0 ? STATS_Z_95_ * stats_sem(stats) / stats->mean : INFINITY;
+}
+
+bool stats_is_converged(const online_stats_t* const stats, const double target_ci_rel)
+{
+    lassert(!is_invalid_ptr(stats), "");
+
+    return target_ci_rel > 0 && stats->cnt >= STATS_MIN_CNT_ && stats_ci_rel(stats) < target_ci_rel;
+}
+#undef STATS_DRIFT_T_
+#undef STATS_DRIFT_REL_
+#undef STATS_OUTLIER_SIGMAS_
+#undef STATS_MIN_CNT_
+#undef STATS_Z_95_
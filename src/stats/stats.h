@@ -0,0 +1,39 @@
+#ifndef STATS_SRC_STATS_STATS_H
+#define STATS_SRC_STATS_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define STATS_WINDOW_SIZE 10
+
+enum StatsSample
+{
+    STATS_SAMPLE_WARMUP     = 0,
+    STATS_SAMPLE_ACCEPTED   = 1,
+    STATS_SAMPLE_OUTLIER    = 2,
+};
+
+typedef struct OnlineStats
+{
+    double window[STATS_WINDOW_SIZE];
+    size_t window_cnt;
+
+    bool is_stationary;
+    size_t warmup_cnt;
+    size_t outliers_cnt;
+
+    size_t cnt;
+    double mean;
+    double m2;
+} online_stats_t;
+
+void                stats_ctor(online_stats_t* const stats);
+enum StatsSample    stats_push(online_stats_t* const stats, const double sample);
+
+double stats_stddev (const online_stats_t* const stats);
+double stats_sem    (const online_stats_t* const stats);
+double stats_ci_rel (const online_stats_t* const stats);
+
+bool stats_is_converged(const online_stats_t* const stats, const double target_ci_rel);
+
+#endif /* STATS_SRC_STATS_STATS_H */
@@ -1,5 +1,14 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cpuid.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -8,6 +17,8 @@
 #include "logger/liblogger.h"
 #include "utils/utils.h"
 #include "sdl_objs/sdl_objs.h"
+#include "stats/stats.h"
+#include "tracer/tracer.h"
 
 #define CASE_ENUM_TO_STRING_(error) case error: return #error
 const char* time_checker_strerror(const enum TimeCheckerError error)
@@ -25,6 +36,22 @@ const char* time_checker_strerror(const enum TimeCheckerError error)
 }
 #undef CASE_ENUM_TO_STRING_
 
+const char* time_checker_stage_name(const enum TimeCheckerStage stage)
+{
+    switch(stage)
+    {
+        case TIME_CHECKER_STAGE_EVENTS:     return "events";
+        case TIME_CHECKER_STAGE_COMPUTE:    return "compute";
+        case TIME_CHECKER_STAGE_COLORIZE:   return "colorize";
+        case TIME_CHECKER_STAGE_UPLOAD:     return "upload";
+        case TIME_CHECKER_STAGE_PRESENT:    return "present";
+        case TIME_CHECKER_STAGES_CNT:
+        default:
+            return "unknown";
+    }
+    return "unknown";
+}
+
 #define SDL_ERROR_HANDLE_(call_func, ...)                                                           \
     do {                                                                                            \
         int error_handler = call_func;                                                              \
@@ -37,6 +64,28 @@ const char* time_checker_strerror(const enum TimeCheckerError error)
         }                                                                                           \
     } while(0)
 
+enum PerfCounter_
+{
+    PERF_COUNTER_CYCLES_        = 0,
+    PERF_COUNTER_INSTRUCTIONS_  = 1,
+    PERF_COUNTER_BRANCH_MISSES_ = 2,
+    PERF_COUNTER_L1D_MISSES_    = 3,
+    PERF_COUNTER_FP_SCALAR_     = 4,
+    PERF_COUNTER_FP_VECTOR_     = 5,
+
+    PERF_COUNTERS_CNT_
+};
+
+typedef struct PerfGroupRead_
+{
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[PERF_COUNTERS_CNT_];
+} perf_group_read_t_;
+
+#define TIME_STR_SIZE 48
+
 static struct 
 {
     size_t frame_cnt;
@@ -44,25 +93,361 @@ static struct
 
     uint64_t last_time_tiks;
     uint64_t tiks;
+
+    uint64_t stage_begin_tiks[TIME_CHECKER_STAGES_CNT];
+    uint64_t stage_tiks      [TIME_CHECKER_STAGES_CNT];
+
+    double tsc_hz;
+    bool is_tsc_invariant;
+
+    size_t pixels_cnt;
+    uint64_t pixel_iters_cnt;
+
+    bool has_workload;
+    mandelbrat2_workload_t workload;
+
+    uint64_t samples_cnt;   // buddhabrot orbits sampled since the last update
+    uint64_t samples_cnt_fps;
+    double samples_per_s;
+
+    online_stats_t compute_stats;
+    enum StatsSample compute_sample;
+    double target_ci_rel;
+
+    bool use_perf;
+    int perf_fds[PERF_COUNTERS_CNT_];
+    size_t perf_group_idx[PERF_COUNTERS_CNT_];
+    perf_group_read_t_ perf_begin;
+    double perf_values[PERF_COUNTERS_CNT_];
     
     Uint32 last_time_fps_ms;
     double fps_update_freq;
     double FPS;
 
+    // the overlay text is rendered again only when it changes
+    char overlay_str[TIME_STR_SIZE];
+    SDL_Texture* overlay_texture;
+    SDL_Rect overlay_pos;
+
     bool use_graphics;
 
     FILE* output_file;
 } TIME_CHECKER_ = {.last_time_fps_ms = 0, .last_time_tiks = 0, .fps_update_freq = 0, .tiks = 0,
                    .frame_cnt_fps = 0, .FPS = 0, .frame_cnt = 0, .use_graphics = false,
-                   .output_file = NULL};
+                   .overlay_str = "", .overlay_texture = NULL,
+                   .output_file = NULL, .tsc_hz = 0, .is_tsc_invariant = false,
+                   .pixels_cnt = 0, .pixel_iters_cnt = 0, .samples_cnt = 0, .use_perf = false,
+                   .compute_sample = STATS_SAMPLE_WARMUP, .target_ci_rel = 0};
+
+#define CPUINFO_LINE_SIZE 8192
+static bool is_tsc_invariant_(void)
+{
+    FILE* const cpuinfo = fopen("/proc/cpuinfo", "rb");
+    if (!cpuinfo)
+    {
+        perror("Can't open /proc/cpuinfo");
+        return false;
+    }
+
+    char line[CPUINFO_LINE_SIZE] = {};
+    bool is_constant = false;
+    bool is_nonstop  = false;
+
+    while (fgets(line, CPUINFO_LINE_SIZE, cpuinfo))
+    {
+        if (strncmp(line, "flags", sizeof("flags") - 1) != 0)
+            continue;
+
+        is_constant = strstr(line, " constant_tsc") != NULL;
+        is_nonstop  = strstr(line, " nonstop_tsc")  != NULL;
+        break;
+    }
+
+    if (fclose(cpuinfo))
+    {
+        perror("Can't fclose /proc/cpuinfo");
+    }
+
+    return is_constant && is_nonstop;
+}
+#undef CPUINFO_LINE_SIZE
+
+static uint64_t monotonic_raw_ns_(void)
+{
+    struct timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+static int cmp_double_(const void* const first, const void* const second)
+{
+    const double first_val  = *(const double*)first;
+    const double second_val = *(const double*)second;
+    return (first_val > second_val) - (first_val < second_val);
+}
+
+#define TSC_CALIBRATION_NS      20000000ull
+#define TSC_CALIBRATION_ROUNDS  5
+static double calibrate_tsc_hz_(void)
+{
+    double rounds_hz[TSC_CALIBRATION_ROUNDS] = {};
+
+    for (size_t round = 0; round < TSC_CALIBRATION_ROUNDS; ++round)
+    {
+        const uint64_t start_ns     = monotonic_raw_ns_();
+        const uint64_t start_tiks   = time_checker_tsc_begin();
+
+        uint64_t end_ns = start_ns;
+        do { end_ns = monotonic_raw_ns_(); } while (end_ns - start_ns < TSC_CALIBRATION_NS);
+
+        const uint64_t end_tiks     = time_checker_tsc_end();
+
+        rounds_hz[round] = (double)(end_tiks - start_tiks) * 1e9 / (double)(end_ns - start_ns);
+    }
+
+    qsort(rounds_hz, TSC_CALIBRATION_ROUNDS, sizeof(*rounds_hz), cmp_double_);
+
+    return rounds_hz[TSC_CALIBRATION_ROUNDS / 2];
+}
+#undef TSC_CALIBRATION_NS
+#undef TSC_CALIBRATION_ROUNDS
+
+// FP_ARITH_INST_RETIRED (event 0xC7) exists since Skylake, i.e. Intel architectural perfmon v4
+#define FP_ARITH_MIN_PERFMON_VERSION 4
+static bool is_fp_arith_available_(void)
+{
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    const bool is_intel = ebx == signature_INTEL_ebx && ecx == signature_INTEL_ecx 
+                                                      && edx == signature_INTEL_edx;
+    if (!is_intel || eax < 0x0A)
+        return false;
+
+    __cpuid(0x0A, eax, ebx, ecx, edx);
+
+    return (eax & 0xFF) >= FP_ARITH_MIN_PERFMON_VERSION;
+}
+#undef FP_ARITH_MIN_PERFMON_VERSION
+
+#define FP_ARITH_EVENT_         0xC7
+#define FP_ARITH_SCALAR_UMASK_  0x03 // scalar double + scalar single
+#define FP_ARITH_VECTOR_UMASK_  0x3C // 128/256-bit packed double + packed single
+static const struct
+{
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+    bool is_fp_arith;
+} PERF_EVENTS_[PERF_COUNTERS_CNT_] = {
+    [PERF_COUNTER_CYCLES_]          = {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,
+                                                                                            false},
+    [PERF_COUNTER_INSTRUCTIONS_]    = {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+                                                                                            false},
+    [PERF_COUNTER_BRANCH_MISSES_]   = {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,
+                                                                                            false},
+    [PERF_COUNTER_L1D_MISSES_]      = {"l1d_misses",    PERF_TYPE_HW_CACHE, 
+                                        PERF_COUNT_HW_CACHE_L1D
+                                     | (PERF_COUNT_HW_CACHE_OP_READ     << 8)
+                                     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),             false},
+    [PERF_COUNTER_FP_SCALAR_]       = {"fp_scalar",     PERF_TYPE_RAW,
+                                        FP_ARITH_EVENT_ | (FP_ARITH_SCALAR_UMASK_ << 8),    true},
+    [PERF_COUNTER_FP_VECTOR_]       = {"fp_vector",     PERF_TYPE_RAW,
+                                        FP_ARITH_EVENT_ | (FP_ARITH_VECTOR_UMASK_ << 8),    true},
+};
+#undef FP_ARITH_EVENT_
+#undef FP_ARITH_SCALAR_UMASK_
+#undef FP_ARITH_VECTOR_UMASK_
+
+static int perf_event_open_(const size_t counter, const int group_fd)
+{
+    struct perf_event_attr attr = {};
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_EVENTS_[counter].type;
+    attr.config         = PERF_EVENTS_[counter].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP 
+                        | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void perf_counters_close_(void)
+{
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        if (TIME_CHECKER_.perf_fds[counter] >= 0 && close(TIME_CHECKER_.perf_fds[counter]))
+        {
+            perror("Can't close perf event fd");
+        }
+        TIME_CHECKER_.perf_fds[counter] = -1;
+    }
+}
+
+// counters that can't be opened (container, perf_event_paranoid, foreign CPU) are printed as nan
+static void perf_counters_open_(void)
+{
+    const bool is_fp_arith = is_fp_arith_available_();
+    size_t group_size = 0;
+
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        TIME_CHECKER_.perf_fds      [counter] = -1;
+        TIME_CHECKER_.perf_group_idx[counter] = 0;
+        TIME_CHECKER_.perf_values   [counter] = 0;
+    }
+
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        if (PERF_EVENTS_[counter].is_fp_arith && !is_fp_arith)
+            continue;
+
+        const int fd = perf_event_open_(counter, TIME_CHECKER_.perf_fds[PERF_COUNTER_CYCLES_]);
+        if (fd < 0)
+        {
+            fprintf(stderr, YELLOW_TEXT("Can't perf_event_open %s: %s\n"), 
+                            PERF_EVENTS_[counter].name, strerror(errno));
+
+            if (counter == PERF_COUNTER_CYCLES_)
+            {
+                fprintf(stderr, YELLOW_TEXT("Perf counters are disabled\n"));
+                TIME_CHECKER_.use_perf = false;
+                return;
+            }
+            continue;
+        }
+
+        TIME_CHECKER_.perf_fds      [counter] = fd;
+        TIME_CHECKER_.perf_group_idx[counter] = group_size++;
+    }
+}
+
+void time_checker_counters_begin(void)
+{
+    if (!TIME_CHECKER_.use_perf)
+        return;
+
+    if (read(TIME_CHECKER_.perf_fds[PERF_COUNTER_CYCLES_], 
+             &TIME_CHECKER_.perf_begin, sizeof(TIME_CHECKER_.perf_begin)) <= 0)
+    {
+        perror("Can't read perf group");
+        TIME_CHECKER_.perf_begin.time_running = 0;
+    }
+}
+
+void time_checker_counters_end(void)
+{
+    if (!TIME_CHECKER_.use_perf)
+        return;
+
+    perf_group_read_t_ end = {};
+    if (read(TIME_CHECKER_.perf_fds[PERF_COUNTER_CYCLES_], &end, sizeof(end)) <= 0)
+    {
+        perror("Can't read perf group");
+        return;
+    }
+
+    const uint64_t enabled = end.time_enabled - TIME_CHECKER_.perf_begin.time_enabled;
+    const uint64_t running = end.time_running - TIME_CHECKER_.perf_begin.time_running;
+    if (running == 0)
+        return;
+
+    // group is scheduled as a whole, so one scale covers multiplexing for all counters
+    const double scale = (double)enabled / (double)running;
+
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        if (TIME_CHECKER_.perf_fds[counter] < 0)
+            continue;
+
+        const size_t idx = TIME_CHECKER_.perf_group_idx[counter];
+        TIME_CHECKER_.perf_values[counter] 
+            += (double)(end.values[idx] - TIME_CHECKER_.perf_begin.values[idx]) * scale;
+    }
+}
+
+static double perf_value_(const size_t counter)
+{
+    return (TIME_CHECKER_.use_perf && TIME_CHECKER_.perf_fds[counter] >= 0) 
+         ? TIME_CHECKER_.perf_values[counter] 
+         : NAN;
+}
+
+static void perf_counters_print_(void)
+{
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        fprintf(TIME_CHECKER_.output_file, " %.0f", perf_value_(counter));
+    }
+
+    const double fp_scalar = perf_value_(PERF_COUNTER_FP_SCALAR_);
+    const double fp_vector = perf_value_(PERF_COUNTER_FP_VECTOR_);
+
+    fprintf(TIME_CHECKER_.output_file, " %.4f %.4f",
+            perf_value_(PERF_COUNTER_INSTRUCTIONS_) / perf_value_(PERF_COUNTER_CYCLES_),
+            fp_vector / (fp_scalar + fp_vector));
+
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        TIME_CHECKER_.perf_values[counter] = 0;
+    }
+}
+
+static enum TimeCheckerError pin_thread_(const int core)
+{
+    lassert(core >= 0 && core < CPU_SETSIZE, "");
+
+    cpu_set_t cpu_set = {};
+    CPU_ZERO(&cpu_set);
+    CPU_SET((size_t)core, &cpu_set);
+
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set))
+    {
+        perror("Can't sched_setaffinity");
+        return TIME_CHECKER_ERROR_STANDARD_ERRNO;
+    }
+
+    return TIME_CHECKER_ERROR_SUCCESS;
+}
 
 enum TimeCheckerError time_checker_ctor(const double fps_update_freq, const bool use_graphics,
-                                        const char* const output_filename)
+                                        const char* const output_filename, const int pin_core,
+                                        const bool use_perf, const double target_ci_rel)
 {
     lassert((long)fps_update_freq, "");
     lassert(!is_invalid_ptr(output_filename), "");
 
-    TIME_CHECKER_.last_time_tiks            = __rdtsc();
+    if (pin_core >= 0)
+    {
+        TIME_CHECKER_ERROR_HANDLE(pin_thread_(pin_core));
+    }
+
+    TIME_CHECKER_.is_tsc_invariant          = is_tsc_invariant_();
+    if (!TIME_CHECKER_.is_tsc_invariant)
+    {
+        fprintf(stderr, YELLOW_TEXT("TSC is not constant_tsc/nonstop_tsc, tiks are not wall time\n"));
+    }
+    TIME_CHECKER_.tsc_hz                    = calibrate_tsc_hz_();
+    TIME_CHECKER_.pixels_cnt                = 0;
+    TIME_CHECKER_.pixel_iters_cnt           = 0;
+    TIME_CHECKER_.has_workload              = false;
+    TIME_CHECKER_.samples_cnt               = 0;
+    TIME_CHECKER_.samples_cnt_fps           = 0;
+    TIME_CHECKER_.samples_per_s             = 0;
+
+    stats_ctor(&TIME_CHECKER_.compute_stats);
+    TIME_CHECKER_.compute_sample            = STATS_SAMPLE_WARMUP;
+    TIME_CHECKER_.target_ci_rel             = target_ci_rel;
+
+    TIME_CHECKER_.use_perf                  = use_perf;
+    if (use_perf)
+    {
+        perf_counters_open_();
+    }
+
+    TIME_CHECKER_.last_time_tiks            = time_checker_tsc_end();
     TIME_CHECKER_.fps_update_freq           = fps_update_freq;
     TIME_CHECKER_.FPS                       = 0;
     TIME_CHECKER_.frame_cnt_fps             = 0;
@@ -70,18 +455,64 @@ enum TimeCheckerError time_checker_ctor(const double fps_update_freq, const bool
     TIME_CHECKER_.frame_cnt                 = 0;
     TIME_CHECKER_.last_time_fps_ms          = SDL_GetTicks();
     TIME_CHECKER_.use_graphics              = use_graphics;
+    TIME_CHECKER_.overlay_str[0]            = '\0';
+    TIME_CHECKER_.overlay_texture           = NULL;
+
+    for (size_t stage = 0; stage < TIME_CHECKER_STAGES_CNT; ++stage)
+    {
+        TIME_CHECKER_.stage_begin_tiks[stage]   = 0;
+        TIME_CHECKER_.stage_tiks      [stage]   = 0;
+    }
     
     if (!(TIME_CHECKER_.output_file = fopen(output_filename, "wb")))
     {
         perror("Can't open output_file");
+        perf_counters_close_();
         return TIME_CHECKER_ERROR_STANDARD_ERRNO;
     }
 
+    fprintf(TIME_CHECKER_.output_file, "# tsc_hz %.0f invariant_tsc %d pin_core %d\n",
+                                       TIME_CHECKER_.tsc_hz, TIME_CHECKER_.is_tsc_invariant, pin_core);
+
+    fprintf(TIME_CHECKER_.output_file, "# frame tiks");
+    for (size_t stage = 0; stage < TIME_CHECKER_STAGES_CNT; ++stage)
+    {
+        fprintf(TIME_CHECKER_.output_file, " %s", time_checker_stage_name((enum TimeCheckerStage)stage));
+    }
+    fprintf(TIME_CHECKER_.output_file, 
+            " ns compute_ns ns_per_pixel ns_per_pixel_iter cycles_per_pixel_iter");
+    for (size_t counter = 0; counter < PERF_COUNTERS_CNT_; ++counter)
+    {
+        fprintf(TIME_CHECKER_.output_file, " %s", PERF_EVENTS_[counter].name);
+    }
+    fprintf(TIME_CHECKER_.output_file, " ipc vector_share sample vector_iters lane_util\n");
+
     return TIME_CHECKER_ERROR_SUCCESS;
 }
 
 enum TimeCheckerError time_checker_dtor(void)
 {
+    if (TIME_CHECKER_.overlay_texture)
+    {
+        SDL_DestroyTexture(TIME_CHECKER_.overlay_texture);
+        TIME_CHECKER_.overlay_texture = NULL;
+    }
+
+    if (TIME_CHECKER_.use_perf)
+    {
+        perf_counters_close_();
+    }
+
+    if (TIME_CHECKER_.output_file)
+    {
+        const online_stats_t* const stats = &TIME_CHECKER_.compute_stats;
+        fprintf(TIME_CHECKER_.output_file, 
+                "# compute_ns warmup %zu accepted %zu outliers %zu mean %.0f sem %.0f ci95_rel %.5f "
+                "converged %d\n",
+                stats->warmup_cnt, stats->cnt, stats->outliers_cnt, stats->mean, stats_sem(stats),
+                stats_ci_rel(stats), stats_is_converged(stats, TIME_CHECKER_.target_ci_rel));
+    }
+
     if (TIME_CHECKER_.output_file && fclose(TIME_CHECKER_.output_file))
     {
         perror("Can't fclose output_file");
@@ -97,15 +528,75 @@ enum TimeCheckerError time_checker_dtor(void)
     IF_DEBUG(TIME_CHECKER_.frame_cnt            = 0);
     IF_DEBUG(TIME_CHECKER_.last_time_fps_ms     = 0);
     IF_DEBUG(TIME_CHECKER_.use_graphics         = false);
+    IF_DEBUG(TIME_CHECKER_.tsc_hz               = 0);
+    IF_DEBUG(TIME_CHECKER_.pixels_cnt           = 0);
+    IF_DEBUG(TIME_CHECKER_.pixel_iters_cnt      = 0);
+    IF_DEBUG(TIME_CHECKER_.samples_cnt          = 0);
+    IF_DEBUG(TIME_CHECKER_.samples_cnt_fps      = 0);
+    IF_DEBUG(TIME_CHECKER_.use_perf             = false);
+    IF_DEBUG(TIME_CHECKER_.target_ci_rel        = 0);
 
     return TIME_CHECKER_ERROR_SUCCESS;
 }
 
+double time_checker_tsc_hz(void)
+{
+    return TIME_CHECKER_.tsc_hz;
+}
+
+double time_checker_tiks_to_ns(const uint64_t tiks)
+{
+    lassert(TIME_CHECKER_.tsc_hz > 0, "");
+
+    return (double)tiks * 1e9 / TIME_CHECKER_.tsc_hz;
+}
+
+void time_checker_set_workload(const size_t pixels_cnt, const uint64_t pixel_iters_cnt)
+{
+    TIME_CHECKER_.pixels_cnt        = pixels_cnt;
+    TIME_CHECKER_.pixel_iters_cnt   = pixel_iters_cnt;
+}
+
+void time_checker_set_samples(const uint64_t samples_cnt)
+{
+    TIME_CHECKER_.samples_cnt       = samples_cnt;
+    TIME_CHECKER_.samples_cnt_fps  += samples_cnt;
+}
+
+bool time_checker_is_converged(void)
+{
+    return stats_is_converged(&TIME_CHECKER_.compute_stats, TIME_CHECKER_.target_ci_rel);
+}
+
+void time_checker_set_workload_details(const mandelbrat2_workload_t* const workload)
+{
+    lassert(!is_invalid_ptr(workload), "");
+
+    TIME_CHECKER_.has_workload  = true;
+    TIME_CHECKER_.workload      = *workload;
+}
+
+void time_checker_stage_begin(const enum TimeCheckerStage stage)
+{
+    lassert(stage < TIME_CHECKER_STAGES_CNT, "");
+
+    TIME_CHECKER_.stage_begin_tiks[stage] = time_checker_tsc_begin();
+}
+
+void time_checker_stage_end(const enum TimeCheckerStage stage)
+{
+    lassert(stage < TIME_CHECKER_STAGES_CNT, "");
+
+    TIME_CHECKER_.stage_tiks[stage] += time_checker_tsc_end() - TIME_CHECKER_.stage_begin_tiks[stage];
+
+    tracer_end(time_checker_stage_name(stage), TIME_CHECKER_.stage_begin_tiks[stage], TRACER_NO_ARG);
+}
+
 enum TimeCheckerError time_checker_update(const sdl_objs_t* const sdl_objs)
 {
     lassert(!is_invalid_ptr(sdl_objs), "");
 
-    const uint64_t cur_time_tiks = __rdtsc();
+    const uint64_t cur_time_tiks = time_checker_tsc_end();
     TIME_CHECKER_.tiks = cur_time_tiks - TIME_CHECKER_.last_time_tiks;
 
     ++TIME_CHECKER_.frame_cnt_fps;
@@ -119,53 +610,37 @@ enum TimeCheckerError time_checker_update(const sdl_objs_t* const sdl_objs)
         if (delta_time_ms >= TIME_CHECKER_.fps_update_freq)
         {
             TIME_CHECKER_.FPS = (double)TIME_CHECKER_.frame_cnt_fps / (double)(delta_time_ms) * 1000.;
+            TIME_CHECKER_.samples_per_s = (double)TIME_CHECKER_.samples_cnt_fps / (double)(delta_time_ms) * 1000.;
     
-            TIME_CHECKER_.frame_cnt_fps = 0;
+            TIME_CHECKER_.frame_cnt_fps     = 0;
+            TIME_CHECKER_.samples_cnt_fps   = 0;
             TIME_CHECKER_.last_time_fps_ms = cur_time_ms;
         }
     }
 
+    TIME_CHECKER_.compute_sample = stats_push(&TIME_CHECKER_.compute_stats, 
+        time_checker_tiks_to_ns(TIME_CHECKER_.stage_tiks[TIME_CHECKER_STAGE_COMPUTE]));
+
     TIME_CHECKER_ERROR_HANDLE(time_checker_print(sdl_objs));
 
     TIME_CHECKER_.last_time_tiks = cur_time_tiks;
 
-    return TIME_CHECKER_ERROR_SUCCESS;
-}
-
-#define TIME_STR_SIZE 16
-enum TimeCheckerError time_checker_print(const sdl_objs_t* const sdl_objs)
-{
-    lassert(!is_invalid_ptr(sdl_objs), "");
-    lassert(!is_invalid_ptr(sdl_objs->font), "");
-    lassert(!is_invalid_ptr(sdl_objs->renderer), "");
-
-    fprintf(TIME_CHECKER_.output_file, "%zu %zu\n", TIME_CHECKER_.frame_cnt, TIME_CHECKER_.tiks);
-
-    if (!TIME_CHECKER_.use_graphics)
-    {
-        return TIME_CHECKER_ERROR_SUCCESS;
-    }
-
-    char* const TIME_str = calloc(TIME_STR_SIZE, sizeof(char));
-    if (!TIME_str)
+    for (size_t stage = 0; stage < TIME_CHECKER_STAGES_CNT; ++stage)
     {
-        perror("Can't calloc TIME_str");
-        return TIME_CHECKER_ERROR_STANDARD_ERRNO;
+        TIME_CHECKER_.stage_tiks[stage] = 0;
     }
+    TIME_CHECKER_.samples_cnt = 0;
 
-    if (!snprintf(TIME_str, TIME_STR_SIZE, "%.2f", TIME_CHECKER_.FPS))
-    {
-        perror("Can't snpritnf FPS to TIME_str");
-        free(TIME_str);
-        return TIME_CHECKER_ERROR_STANDARD_ERRNO;
-    }
+    return TIME_CHECKER_ERROR_SUCCESS;
+}
 
+static enum TimeCheckerError render_overlay_(const sdl_objs_t* const sdl_objs, const char* const TIME_str)
+{
     SDL_Surface *TIME_surface = TTF_RenderText_Blended(
         sdl_objs->font, 
         TIME_str, 
         (SDL_Color){255, 255, 255, 255} // black
     );
-    free(TIME_str);
 
     if (!TIME_surface){
         fprintf(stderr, "Can't TTF_RenderText_Blended for create TIME_surface. Error: %s", 
@@ -188,11 +663,94 @@ enum TimeCheckerError time_checker_print(const sdl_objs_t* const sdl_objs)
         SDL_DestroyTexture(TIME_texture);
     );
 
-    SDL_ERROR_HANDLE_(SDL_RenderCopy(sdl_objs->renderer, TIME_texture, NULL, &pos), 
-        SDL_DestroyTexture(TIME_texture);
-    );
+    if (TIME_CHECKER_.overlay_texture)
+    {
+        SDL_DestroyTexture(TIME_CHECKER_.overlay_texture);
+    }
+    TIME_CHECKER_.overlay_texture   = TIME_texture;
+    TIME_CHECKER_.overlay_pos       = pos;
+    strcpy(TIME_CHECKER_.overlay_str, TIME_str);
+
+    return TIME_CHECKER_ERROR_SUCCESS;
+}
+
+enum TimeCheckerError time_checker_print(const sdl_objs_t* const sdl_objs)
+{
+    lassert(!is_invalid_ptr(sdl_objs), "");
+
+    // stages are accumulated between two updates, so present of the previous frame
+    // falls into the same line as its tiks window
+    fprintf(TIME_CHECKER_.output_file, "%zu %zu", TIME_CHECKER_.frame_cnt, TIME_CHECKER_.tiks);
+    for (size_t stage = 0; stage < TIME_CHECKER_STAGES_CNT; ++stage)
+    {
+        fprintf(TIME_CHECKER_.output_file, " %zu", TIME_CHECKER_.stage_tiks[stage]);
+    }
+
+    const uint64_t compute_tiks     = TIME_CHECKER_.stage_tiks[TIME_CHECKER_STAGE_COMPUTE];
+    const double   compute_ns       = time_checker_tiks_to_ns(compute_tiks);
+    const double   pixels_cnt       = (double)MAX(TIME_CHECKER_.pixels_cnt,      1lu);
+    const double   pixel_iters_cnt  = (double)MAX(TIME_CHECKER_.pixel_iters_cnt, 1lu);
+
+    fprintf(TIME_CHECKER_.output_file, " %.0f %.0f %.4f %.4f %.4f", 
+            time_checker_tiks_to_ns(TIME_CHECKER_.tiks), compute_ns,
+            compute_ns / pixels_cnt, compute_ns / pixel_iters_cnt, 
+            (double)compute_tiks / pixel_iters_cnt);
+
+    perf_counters_print_();
+    fprintf(TIME_CHECKER_.output_file, " %d", (int)TIME_CHECKER_.compute_sample);
+
+    if (TIME_CHECKER_.has_workload)
+    {
+        const mandelbrat2_workload_t* const workload = &TIME_CHECKER_.workload;
+
+        fprintf(TIME_CHECKER_.output_file, " %zu %.4f\n# hist %zu %zu %zu", 
+                workload->vector_iters, mandelbrat2_lane_utilization(workload),
+                TIME_CHECKER_.frame_cnt, workload->hist_bin_width, workload->interior_cnt);
+        for (size_t bin = 0; bin < MANDELBRAT2_HIST_BINS; ++bin)
+        {
+            fprintf(TIME_CHECKER_.output_file, " %zu", workload->hist[bin]);
+        }
+    }
+    else
+    {
+        fprintf(TIME_CHECKER_.output_file, " nan nan");
+    }
+    fprintf(TIME_CHECKER_.output_file, "\n");
+
+    const double samples_per_s = TIME_CHECKER_.samples_cnt ? (double)TIME_CHECKER_.samples_cnt * 1e9 
+                                                             / MAX(compute_ns, 1.) : 0;
+    if (TIME_CHECKER_.samples_cnt)
+    {
+        fprintf(TIME_CHECKER_.output_file, "# samples %zu %zu %.0f\n", 
+                TIME_CHECKER_.frame_cnt, TIME_CHECKER_.samples_cnt, samples_per_s);
+    }
+
+    if (!TIME_CHECKER_.use_graphics)
+    {
+        return TIME_CHECKER_ERROR_SUCCESS;
+    }
+
+    lassert(!is_invalid_ptr(sdl_objs->font), "");
+    lassert(!is_invalid_ptr(sdl_objs->renderer), "");
+
+    char TIME_str[TIME_STR_SIZE] = {};
+    const int TIME_str_len = TIME_CHECKER_.samples_per_s > 0
+                           ? snprintf(TIME_str, TIME_STR_SIZE, "%.2f %.2f Msamples/s", TIME_CHECKER_.FPS, 
+                                      TIME_CHECKER_.samples_per_s * 1e-6)
+                           : snprintf(TIME_str, TIME_STR_SIZE, "%.2f", TIME_CHECKER_.FPS);
+    if (TIME_str_len <= 0)
+    {
+        perror("Can't snpritnf FPS to TIME_str");
+        return TIME_CHECKER_ERROR_STANDARD_ERRNO;
+    }
+
+    if (!TIME_CHECKER_.overlay_texture || strcmp(TIME_str, TIME_CHECKER_.overlay_str))
+    {
+        TIME_CHECKER_ERROR_HANDLE(render_overlay_(sdl_objs, TIME_str));
+    }
 
-    SDL_DestroyTexture(TIME_texture);
+    SDL_ERROR_HANDLE_(SDL_RenderCopy(sdl_objs->renderer, TIME_CHECKER_.overlay_texture, NULL, 
+                                     &TIME_CHECKER_.overlay_pos));
 
     return TIME_CHECKER_ERROR_SUCCESS;
 }
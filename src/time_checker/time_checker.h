@@ -2,11 +2,14 @@
 #define TIME_CHECKER_SRC_TIME_CHECKER_TIME_CHECKER_H
 
 #include <assert.h>
+#include <stdint.h>
+#include <x86intrin.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
 #include "sdl_objs/sdl_objs.h"
+#include "mandelbrat2/mandelbrat2.h"
 
 enum TimeCheckerError
 {
@@ -31,11 +34,56 @@ const char* time_checker_strerror(const enum TimeCheckerError error);
         }                                                                                           \
     } while(0)
 
-#endif /* TIME_CHECKER_SRC_TIME_CHECKER_TIME_CHECKER_H */
+enum TimeCheckerStage
+{
+    TIME_CHECKER_STAGE_EVENTS       = 0,
+    TIME_CHECKER_STAGE_COMPUTE      = 1,
+    TIME_CHECKER_STAGE_COLORIZE     = 2,
+    TIME_CHECKER_STAGE_UPLOAD       = 3,
+    TIME_CHECKER_STAGE_PRESENT      = 4,
+
+    TIME_CHECKER_STAGES_CNT
+};
+
+const char* time_checker_stage_name(const enum TimeCheckerStage stage);
+
+static inline uint64_t time_checker_tsc_begin(void)
+{
+    _mm_lfence();
+    const uint64_t tsc = __rdtsc();
+    _mm_lfence();
+    return tsc;
+}
+
+static inline uint64_t time_checker_tsc_end(void)
+{
+    unsigned aux = 0;
+    const uint64_t tsc = __rdtscp(&aux);
+    _mm_lfence();
+    return tsc;
+}
 
 enum TimeCheckerError time_checker_ctor(const double fps_update_freq, const bool use_graphics,
-                                        const char* const output_filename);
+                                        const char* const output_filename, const int pin_core,
+                                        const bool use_perf, const double target_ci_rel);
 enum TimeCheckerError time_checker_dtor(void);
 
+double time_checker_tsc_hz      (void);
+double time_checker_tiks_to_ns  (const uint64_t tiks);
+
+void time_checker_set_workload        (const size_t pixels_cnt, const uint64_t pixel_iters_cnt);
+void time_checker_set_workload_details(const mandelbrat2_workload_t* const workload);
+void time_checker_set_samples         (const uint64_t samples_cnt);
+
+bool time_checker_is_converged(void);
+
+void time_checker_counters_begin(void);
+void time_checker_counters_end  (void);
+
+void time_checker_stage_begin(const enum TimeCheckerStage stage);
+void time_checker_stage_end  (const enum TimeCheckerStage stage);
+
 enum TimeCheckerError time_checker_update(const sdl_objs_t* const sdl_objs);
-enum TimeCheckerError time_checker_print (const sdl_objs_t* const sdl_objs);
\ No newline at end of file
+enum TimeCheckerError time_checker_print (const sdl_objs_t* const sdl_objs);
+
+#endif /* TIME_CHECKER_SRC_TIME_CHECKER_TIME_CHECKER_H */
\ No newline at end of file
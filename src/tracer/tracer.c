@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "tracer/tracer.h"
+#include "logger/liblogger.h"
+#include "utils/utils.h"
+
+#define CASE_ENUM_TO_STRING_(error) case error: return #error
+const char* tracer_strerror(const enum TracerError error)
+{
+    switch(error)
+    {
+        CASE_ENUM_TO_STRING_(TRACER_ERROR_SUCCESS);
+        CASE_ENUM_TO_STRING_(TRACER_ERROR_STANDARD_ERRNO);
+        default:
+            return "UNKNOWN_TRACER_ERROR";
+    }
+    return "UNKNOWN_TRACER_ERROR";
+}
+#undef CASE_ENUM_TO_STRING_
+
+typedef struct TracerEvent
+{
+    const char* name;
+    uint64_t begin_tiks;
+    uint64_t end_tiks;
+    long arg;
+} tracer_event_t;
+
+// written only by its owner thread, read at dtor after all workers joined
+typedef struct TracerBuffer
+{
+    tracer_event_t* events;
+    size_t cnt;
+    size_t dropped_cnt;
+    long tid;
+} __attribute__((aligned(64))) tracer_buffer_t;
+
+static struct
+{
+    bool is_enabled;
+    char filename[FILENAME_MAX + 1];
+    uint64_t start_tiks;
+
+    atomic_size_t threads_cnt;
+    tracer_buffer_t buffers[TRACER_MAX_THREADS];
+} TRACER_ = {.is_enabled = false};
+
+static _Thread_local tracer_buffer_t* THREAD_BUFFER_ = NULL;
+
+enum TracerError tracer_ctor(const char* const filename)
+{
+    lassert(!is_invalid_ptr(filename), "");
+
+    TRACER_.is_enabled = filename[0] != '\0';
+    if (!TRACER_.is_enabled)
+        return TRACER_ERROR_SUCCESS;
+
+    if (!strncpy(TRACER_.filename, filename, FILENAME_MAX))
+    {
+        perror("Can't strncpy TRACER_.filename");
+        return TRACER_ERROR_STANDARD_ERRNO;
+    }
+
+    atomic_init(&TRACER_.threads_cnt, 0);
+    memset(TRACER_.buffers, 0, sizeof(TRACER_.buffers));
+
+    TRACER_.start_tiks = time_checker_tsc_begin();
+
+    return TRACER_ERROR_SUCCESS;
+}
+
+bool tracer_is_enabled(void)
+{
+    return TRACER_.is_enabled;
+}
+
+// the buffer is allocated by the thread that fills it, so its pages are first touched there
+static tracer_buffer_t* thread_buffer_(void)
+{
+    if (THREAD_BUFFER_)
+        return THREAD_BUFFER_;
+
+    const size_t slot = atomic_fetch_add_explicit(&TRACER_.threads_cnt, 1, memory_order_relaxed);
+    if (slot >= TRACER_MAX_THREADS)
+        return NULL;
+
+    tracer_buffer_t* const buffer = &TRACER_.buffers[slot];
+    buffer->tid     = (long)syscall(SYS_gettid);
+    buffer->events  = calloc(TRACER_EVENTS_PER_THREAD, sizeof(*buffer->events));
+    if (!buffer->events)
+    {
+        perror("Can't calloc tracer buffer");
+    }
+
+    THREAD_BUFFER_ = buffer;
+    return buffer;
+}
+
+void tracer_end(const char* const name, const uint64_t begin_tiks, const long arg)
+{
+    if (!TRACER_.is_enabled)
+        return;
+
+    const uint64_t end_tiks = time_checker_tsc_end();
+
+    tracer_buffer_t* const buffer = thread_buffer_();
+    if (!buffer)
+        return;
+
+    if (!buffer->events || buffer->cnt == TRACER_EVENTS_PER_THREAD)
+    {
+        ++buffer->dropped_cnt;
+        return;
+    }
+
+    buffer->events[buffer->cnt++] = (tracer_event_t){.name = name, .begin_tiks = begin_tiks,
+                                                     .end_tiks = end_tiks, .arg = arg};
+}
+
+static double tiks_to_us_(const uint64_t tiks)
+{
+    return (double)tiks * 1e6 / time_checker_tsc_hz();
+}
+
+static void write_events_(FILE* const out)
+{
+    const size_t THREADS_CNT = MIN(atomic_load(&TRACER_.threads_cnt), (size_t)TRACER_MAX_THREADS);
+    const long   PID         = (long)getpid();
+    bool is_first = true;
+
+    for (size_t slot = 0; slot < THREADS_CNT; ++slot)
+    {
+        const tracer_buffer_t* const buffer = &TRACER_.buffers[slot];
+
+        fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%zu,"
+                     "\"args\":{\"name\":\"%s %ld\"}}",
+                     is_first ? "" : ",", PID, slot, buffer->tid == PID ? "main" : "worker", buffer->tid);
+        is_first = false;
+
+        for (size_t event = 0; event < buffer->cnt; ++event)
+        {
+            const tracer_event_t* const cur = &buffer->events[event];
+
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"mandelbrat2\",\"ph\":\"X\",\"pid\":%ld,"
+                         "\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f",
+                         cur->name, PID, slot, tiks_to_us_(cur->begin_tiks - TRACER_.start_tiks),
+                         tiks_to_us_(cur->end_tiks - cur->begin_tiks));
+            if (cur->arg != TRACER_NO_ARG)
+            {
+                fprintf(out, ",\"args\":{\"arg\":%ld}", cur->arg);
+            }
+            fprintf(out, "}");
+        }
+    }
+}
+
+enum TracerError tracer_dtor(void)
+{
+    if (!TRACER_.is_enabled)
+        return TRACER_ERROR_SUCCESS;
+
+    TRACER_.is_enabled = false;
+
+    const size_t THREADS_CNT = MIN(atomic_load(&TRACER_.threads_cnt), (size_t)TRACER_MAX_THREADS);
+    size_t dropped_cnt = 0;
+    for (size_t slot = 0; slot < THREADS_CNT; ++slot)
+    {
+        dropped_cnt += TRACER_.buffers[slot].dropped_cnt;
+    }
+    if (atomic_load(&TRACER_.threads_cnt) > TRACER_MAX_THREADS)
+    {
+        fprintf(stderr, YELLOW_TEXT("Tracer: %zu threads over the limit of %d were not traced\n"),
+                        atomic_load(&TRACER_.threads_cnt) - TRACER_MAX_THREADS, TRACER_MAX_THREADS);
+    }
+    if (dropped_cnt)
+    {
+        fprintf(stderr, YELLOW_TEXT("Tracer: %zu spans dropped, buffers are full\n"), dropped_cnt);
+    }
+
+    enum TracerError error = TRACER_ERROR_SUCCESS;
+
+    FILE* const out = fopen(TRACER_.filename, "wb");
+    if (!out)
+    {
+        perror("Can't fopen trace file");
+        error = TRACER_ERROR_STANDARD_ERRNO;
+    }
+    else
+    {
+        fprintf(out, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"tsc_hz\":%.0f,\"dropped\":%zu},"
+                     "\"traceEvents\":[", time_checker_tsc_hz(), dropped_cnt);
+        write_events_(out);
+        fprintf(out, "\n]}\n");
+
+        if (fclose(out))
+        {
+            perror("Can't fclose trace file");
+            error = TRACER_ERROR_STANDARD_ERRNO;
+        }
+    }
+
+    for (size_t slot = 0; slot < THREADS_CNT; ++slot)
+    {
+        free(TRACER_.buffers[slot].events);
+        IF_DEBUG(TRACER_.buffers[slot].events = NULL);
+    }
+
+    return error;
+}
@@ -0,0 +1,49 @@
+#ifndef TRACER_SRC_TRACER_TRACER_H
+#define TRACER_SRC_TRACER_TRACER_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "time_checker/time_checker.h"
+
+enum TracerError
+{
+    TRACER_ERROR_SUCCESS            = 0,
+    TRACER_ERROR_STANDARD_ERRNO     = 1,
+};
+static_assert(TRACER_ERROR_SUCCESS  == 0, "");
+
+const char* tracer_strerror(const enum TracerError error);
+
+#define TRACER_ERROR_HANDLE(call_func, ...)                                                         \
+    do {                                                                                            \
+        enum TracerError error_handler = call_func;                                                 \
+        if (error_handler)                                                                          \
+        {                                                                                           \
+            fprintf(stderr, "Can't " #call_func". Error: %s\n",                                     \
+                            tracer_strerror(error_handler));                                        \
+            __VA_ARGS__                                                                             \
+            return error_handler;                                                                   \
+        }                                                                                           \
+    } while(0)
+
+#define TRACER_MAX_THREADS          64
+#define TRACER_EVENTS_PER_THREAD    (1lu << 20)
+#define TRACER_NO_ARG               (-1l)
+
+// empty filename keeps the tracer disabled, then spans cost one predictable branch
+enum TracerError tracer_ctor(const char* const filename);
+enum TracerError tracer_dtor(void);
+
+bool tracer_is_enabled(void);
+
+static inline uint64_t tracer_begin(void)
+{
+    return tracer_is_enabled() ? time_checker_tsc_begin() : 0;
+}
+
+// name must be a string literal, only the pointer is stored
+void tracer_end(const char* const name, const uint64_t begin_tiks, const long arg);
+
+#endif /* TRACER_SRC_TRACER_TRACER_H */
@@ -5,52 +5,121 @@
 #include <stdint.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdbool.h>
+#include <pthread.h>
 
 #include "utils.h"
 #include "logger/liblogger.h"
 
-enum PtrState is_invalid_ptr(const void* ptr)
+// Readable mappings of /proc/self/maps, sorted and merged. A pointer outside of them makes the
+// index reread once, so new mappings are picked up lazily; stale ones are dropped on that reread.
+typedef struct PtrInterval
 {
-    errno = 0;
-    if (ptr == NULL)
+    uintptr_t begin;
+    uintptr_t end;
+} ptr_interval_t;
+
+static struct
+{
+    ptr_interval_t* intervals;
+    size_t cnt;
+    size_t capacity;
+    pthread_rwlock_t lock;
+} PTR_INDEX_ = {.intervals = NULL, .cnt = 0, .capacity = 0, .lock = PTHREAD_RWLOCK_INITIALIZER};
+
+static bool find_ptr_(const uintptr_t ptr)
+{
+    size_t left  = 0;
+    size_t right = PTR_INDEX_.cnt;
+    while (left < right)
     {
-        return PTR_STATES_NULL;
+        const size_t mid = left + ((right - left) >> 1);
+        if (PTR_INDEX_.intervals[mid].end <= ptr)
+            left  = mid + 1;
+        else
+            right = mid;
     }
 
-    char filename[] = "/tmp/chupapi_munyanya.XXXXXX";
-    const int fd = mkstemp(filename);
+    return left < PTR_INDEX_.cnt && PTR_INDEX_.intervals[left].begin <= ptr;
+}
 
-    if (fd == -1) 
+// the kernel lists mappings by address, so adjacent ones are merged on the fly
+static enum PtrState reload_ptr_index_(void)
+{
+    FILE* const maps = fopen("/proc/self/maps", "rb");
+    if (!maps)
     {
-        perror("Can't mkstemp file");
+        perror("Can't fopen /proc/self/maps");
         return PTR_STATES_ERROR;
     }
-    
-    const ssize_t write_result = write(fd, ptr, 1);
 
-    if (remove(filename))
+    PTR_INDEX_.cnt = 0;
+
+    unsigned long begin = 0;
+    unsigned long end   = 0;
+    char perms[8] = {};
+    while (fscanf(maps, "%lx-%lx %4s %*[^\n]", &begin, &end, perms) == 3)
     {
-        perror("Can't remove temp file");
-        return PTR_STATES_ERROR;
+        if (perms[0] != 'r')
+            continue;
+
+        if (PTR_INDEX_.cnt && PTR_INDEX_.intervals[PTR_INDEX_.cnt - 1].end == begin)
+        {
+            PTR_INDEX_.intervals[PTR_INDEX_.cnt - 1].end = end;
+            continue;
+        }
+
+        if (PTR_INDEX_.cnt == PTR_INDEX_.capacity)
+        {
+            const size_t capacity = MAX(PTR_INDEX_.capacity << 1, (size_t)64);
+            ptr_interval_t* const intervals = realloc(PTR_INDEX_.intervals, capacity * sizeof(*intervals));
+            if (!intervals)
+            {
+                perror("Can't realloc ptr intervals");
+                fclose(maps);
+                return PTR_STATES_ERROR;
+            }
+            PTR_INDEX_.intervals = intervals;
+            PTR_INDEX_.capacity  = capacity;
+        }
+
+        PTR_INDEX_.intervals[PTR_INDEX_.cnt++] = (ptr_interval_t){.begin = begin, .end = end};
     }
 
-    if (close(fd))
+    if (fclose(maps))
     {
-        perror("Can't close temp file");
+        perror("Can't fclose /proc/self/maps");
         return PTR_STATES_ERROR;
     }
 
-    if (write_result == 1)
+    return PTR_STATES_VALID;
+}
+
+enum PtrState is_invalid_ptr(const void* ptr)
+{
+    if (ptr == NULL)
+    {
+        return PTR_STATES_NULL;
+    }
+
+    pthread_rwlock_rdlock(&PTR_INDEX_.lock);
+    const bool is_found = find_ptr_((uintptr_t)ptr);
+    pthread_rwlock_unlock(&PTR_INDEX_.lock);
+
+    if (is_found)
         return PTR_STATES_VALID;
 
-    if (errno == EFAULT) 
+    pthread_rwlock_wrlock(&PTR_INDEX_.lock);
+    const int saved_errno = errno;
+    enum PtrState state = reload_ptr_index_();
+    errno = saved_errno;
+    if (state == PTR_STATES_VALID && !find_ptr_((uintptr_t)ptr))
     {
-        errno = 0;
-        return PTR_STATES_INVALID;
+        state = PTR_STATES_INVALID;
     }
-    
-    perror("Unpredictable errno state, after write into temp file");
-    return PTR_STATES_ERROR;
+    pthread_rwlock_unlock(&PTR_INDEX_.lock);
+
+    return state;
 }
 
 int is_empty_file (FILE* file)
@@ -21,6 +21,7 @@
 
 #define OFFSET_STEP       20
 #define SCALE_STEP        0.1f
+#define ITERS_STEP        2
 
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))